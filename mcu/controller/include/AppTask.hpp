@@ -8,14 +8,48 @@ namespace App
 {
     /**
      * @brief Task that handles most of the hardware and MODBUS communication + heartbeating.
+     * Runs init() and then step() with period chosen by Cadence.
     */
     void task(void *pvParameters __attribute__((unused)));
 
+    /**
+     * @brief Initialize hardware handled by the task.
+    */
+    void init();
+
+    /**
+     * @brief Single loop iteration, never blocks.
+    */
+    void step();
+
+    constexpr uint8_t STATES = 5;
+
+    /**
+     * @brief Visits of single state since power on.
+     */
+    struct StateStats
+    {
+        uint16_t entries = 0;
+        uint16_t lastDwell = 0; // s spent in last completed visit.
+    };
+
+    /**
+     * @brief State machine timing, states indexed in order OFF, BOOTING, CONNECTED, SHUTTING_DOWN, ERROR.
+     */
+    struct Stats
+    {
+        StateStats states[STATES];
+        uint16_t lastLatency = 0; // us taken by exit, action and entry of last transition.
+        uint16_t maxLatency = 0;
+    };
+
+    Stats stats();
+
     /**
      * @brief Get FreeRTOS stack size required to run this task.
     */
     constexpr uint16_t getRequiredStack()
     {
-        return 173;
+        return 192;
     }
 }
@@ -0,0 +1,84 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief SBC boot supervision with timeout learned from recent boots, and shutdown timing.
+ *
+ * SBC advances boot phase register as it comes up, each phase is timestamped from power on.
+ * Times of last successful boots are kept in EEPROM and deadline of the next awaited phase
+ * is derived from the slowest of them, so a hung boot is detected long before the fixed
+ * Settings::bootTimeout(), which remains the upper bound and is used until there is history.
+ */
+namespace Boot
+{
+    enum class Phase : uint8_t
+    {
+        POWERED = 0,
+        DAEMON = 1, // Reached implicitly when SBC heartbeat connects.
+        FRONTEND = 2
+    };
+
+    constexpr uint8_t PHASES = 3;
+
+    /**
+     * @brief Boot counters, times in 100 ms since power on, 0 if unknown.
+     */
+    struct Stats
+    {
+        uint8_t phase = 0;
+        uint8_t records = 0;                // Boots in history.
+        uint16_t timeouts = 0;              // Boots failed by learned deadline.
+        uint16_t lateFrontends = 0;         // Of them, boots whose FRONTEND was late after DAEMON was up.
+        uint16_t last[PHASES - 1] = {};     // Time each phase was reached in current or last boot.
+        uint16_t deadline[PHASES - 1] = {}; // Learned deadline of each phase.
+        uint16_t shutdown = 0;              // Time from shutdown start to halt or power cut in last shutdown.
+        uint16_t earlyCuts = 0;             // Shutdowns cut after detected halt.
+        uint16_t lateCuts = 0;              // Shutdowns cut after full shutdown duration.
+    };
+
+    /**
+     * @brief Load boot history from EEPROM.
+     */
+    void init();
+
+    /**
+     * @brief SBC was powered on now.
+     */
+    void start();
+
+    /**
+     * @brief Phase reported by SBC, older and unknown phases are ignored. Boot is recorded when FRONTEND is reached.
+     */
+    void report(uint8_t phase);
+
+    /**
+     * @brief Whether awaited phase missed its deadline.
+     */
+    bool timedOut();
+
+    /**
+     * @brief Whether SBC daemon is up but FRONTEND missed its learned deadline. False without FRONTEND history,
+     * SBC may not report it at all.
+     */
+    bool frontendTimedOut();
+
+    /**
+     * @brief Boot missed its deadline. History is dropped so next boot relearns it with the fixed timeout.
+     */
+    void fail();
+
+    /**
+     * @brief SBC was powered off or lost. Boot that got at least to DAEMON is recorded if it wasn't yet.
+     */
+    void finish();
+
+    /**
+     * @brief SBC shutdown ended by power cut.
+     *
+     * @param duration ms from shutdown start to detected halt, or to cut if halt wasn't detected.
+     * @param halted Whether halt was detected.
+     */
+    void shutdown(unsigned long duration, bool halted);
+
+    Stats stats();
+}
\ No newline at end of file
@@ -1,40 +1,81 @@
 #pragma once
 #include <Arduino.h>
+#include "Pin.hpp"
 
 /**
- * @brief Simple GPIO button.
+ * @brief Button sampled by pin change interrupt, see PinButton for GPIO binding.
+ *
+ * ISR only queues timestamped edges, debouncing and gesture recognition
+ * are done in update() so events carry the time of the actual edge.
 */
 class Button
 {
-    bool RELEASED = false;
-    bool PRESSED = true;
+    static constexpr uint8_t QUEUE_SIZE = 8;
 
-    const uint8_t m_pin;
+    struct Edge
+    {
+        uint16_t stamp; // Lower bits of millis().
+        bool pressed;
+    };
+
+    // Written by ISR.
+    volatile Edge m_queue[QUEUE_SIZE];
+    volatile uint8_t m_queueHead = 0;
+    volatile uint8_t m_queueTail = 0;
+    volatile bool m_queueOverflow = false;
+    bool m_lastEdgePressed = false; // Filters out changes of other pins sharing the vector.
+
+    // Debouncer.
+    bool m_stablePressed = false;
+    bool m_pending = false;
+    bool m_pendingPressed = false;
+    unsigned long m_pendingStartStamp = 0; // First edge of bouncing burst.
+    unsigned long m_pendingLastStamp = 0;  // Last edge of bouncing burst.
+
+    // Gesture recognizer.
+    unsigned long m_pressedStartStamp = 0;
+    unsigned long m_eventStamp = 0;
+    bool m_heldAtInit = false; // Press down already at init, no gesture until release.
 
-    bool m_previousState = false;
     bool m_clicked = false;
     bool m_longPressed = false;
-    bool m_fstScan = true;
-    unsigned long m_pressedStartStamp = 0;
+
+    /**
+     * @brief Pop oldest edge from ISR queue.
+     *
+     * @return False if queue is empty.
+     */
+    bool popEdge(Edge &edge);
+
+    /**
+     * @brief Feed debounced level change into gesture recognizer.
+     */
+    void onStableChange(bool pressed, unsigned long stamp);
 
 public:
     /**
-     * @brief Class constructor.
-     * 
-     * @param pin GPIO to use
-     * @param activeLow Whether digital 0 means that button is pressed.
+     * @param pressed Current state of the button. Press held at init gives no click
+     * or long press.
     */
-    Button(uint8_t pin, bool activeLow);
+    void init(bool pressed);
 
-    void init();
+    /**
+     * @brief Queue edge of button pin. Call from pin change ISR.
+     * Calls that don't change the state are ignored, so the vector can be shared with other pins.
+     *
+     * @param pressed State of the button after the edge.
+    */
+    void onEdge(bool pressed);
 
     /**
-     * @brief Update internal state. Call as frequently as possible.
+     * @brief Process queued edges. Call as frequently as possible.
+     *
+     * @param pressed Current state of the button, used if edges were lost.
     */
-    void update();
+    void update(bool pressed);
 
     /**
-     * @brief Whether button is pressed.
+     * @brief Whether button is pressed (debounced).
     */
     bool pressed();
 
@@ -48,8 +89,49 @@ public:
     */
     bool clicked();
 
+    /**
+     * @brief millis() of the edge that caused last click.
+    */
+    unsigned long eventStamp();
+
     /**
      * @brief Clear any events that occured. Use each time event was read.
     */
     void clearState();
+};
+
+/**
+ * @brief Button bound to compile time GPIO.
+ *
+ * @tparam PinT Pin type, logical true means pressed.
+*/
+template <class PinT>
+class PinButton : public Button
+{
+public:
+    /**
+     * @brief Configure GPIO and enable its pin change interrupt, ISR must call onEdge().
+    */
+    void init()
+    {
+        PinT::input();
+        Button::init(PinT::read());
+        PinT::enableChangeInterrupt();
+    }
+
+    /**
+     * @brief Queue edge of button pin. Call from pin change ISR.
+    */
+    void onEdge()
+    {
+        Button::onEdge(PinT::read());
+    }
+
+    /**
+     * @brief Process queued edges. Call as frequently as possible.
+    */
+    void update()
+    {
+        Button::update(PinT::read());
+    }
 };
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief App loop period chosen from recent activity.
+ *
+ * Input or state changing MODBUS writes run the loop at Config::AppTask::FAST_LOOP_PERIOD for
+ * ACTIVITY_HOLD ms, an animated LED effect keeps ANIMATION_LOOP_PERIOD. Otherwise the
+ * loop runs at LOOP_PERIOD and backs off to IDLE_LOOP_PERIOD after STABLE_DELAY.
+ *
+ * FreeRTOS delays are rounded to whole ticks, periods below ~15 ms need TIMER2_TICK or COOP_EXECUTOR.
+ */
+namespace Cadence
+{
+    enum class Mode : uint8_t
+    {
+        FAST,
+        ANIMATION,
+        NORMAL,
+        IDLE
+    };
+
+    constexpr uint8_t MODES = 4;
+
+    /**
+     * @brief Current period and time spent in each mode since boot, seconds saturate.
+     */
+    struct Stats
+    {
+        uint16_t period = 0;
+        uint8_t mode = 0;
+        uint16_t seconds[MODES] = {0, 0, 0, 0};
+    };
+
+    /**
+     * @brief Input or SBC write changing state seen, loop runs fast for a while.
+     *
+     * Routine polls and heartbeats must not call it, else the loop never gets IDLE.
+     */
+    void activity();
+
+    /**
+     * @brief Choose period of next loop iteration. Call once per App loop iteration.
+     *
+     * @param animating Whether LED effect changes outputs on its own.
+     * @return Period in ms.
+     */
+    uint16_t update(bool animating);
+
+    /**
+     * @brief Period chosen by last update().
+     */
+    uint16_t period();
+
+    Stats stats();
+}
\ No newline at end of file
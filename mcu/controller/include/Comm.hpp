@@ -21,13 +21,43 @@ namespace Comm
     */
     bool connected();
 
+    /**
+     * @brief ms since SBC heartbeat last changed, resolution is heartbeat check period.
+     */
+    unsigned long heartbeatSilence();
+
     /**
      * @brief Reset connection status to disconnected.
      */
     void disconnect();
 
+    /**
+     * @brief Consider SBC connected until its heartbeat proves otherwise, after MCU reset.
+     */
+    void assumeConnected();
+
     /**
      * @brief Clear shutdown flag.
      */
     void clearShutdownFlag();
+
+    /**
+     * @brief Clear boot phase left by previous boot.
+     */
+    void clearBootPhase();
+
+    /**
+     * @brief Set display state in State, its MODBUS coil follows on next update().
+     */
+    void setDisplayState(bool state);
+
+    /**
+     * @brief Set joystick enables and brightness in State, their MODBUS registers follow on next update().
+     */
+    void setJoys(bool joy1Enable, bool joy2Enable, uint8_t joy1Brightness, uint8_t joy2Brightness);
+
+    /**
+     * @brief Report scene with given sequence number as fully applied.
+     */
+    void setSceneDone(uint16_t seq);
 }
@@ -16,10 +16,21 @@ namespace Config
         }
     }
 
+    namespace Sync
+    {
+        constexpr uint8_t MUTEX_TIMEOUT = 75; // ms to wait for mutex before the guarded operation is dropped.
+    }
+
     namespace AppTask
     {
         constexpr unsigned long BOOT_TIMEOUT_DURATION = 240000; // If boot time exceeds this time the app goes into error state.
         constexpr unsigned long SHUTDOWN_DURATION = 60000;      // How long to wait for shutdown to turn off SBC.
+        constexpr uint16_t LOOP_PERIOD = 20;                    // Delay between app loop iterations, see Cadence.
+        constexpr uint16_t FAST_LOOP_PERIOD = 2;                // During input or state changing MODBUS writes.
+        constexpr uint16_t ANIMATION_LOOP_PERIOD = 10;          // While LED effect animates, enough for smooth fades.
+        constexpr uint16_t IDLE_LOOP_PERIOD = 80;               // Nothing happened for STABLE_DELAY.
+        constexpr uint16_t ACTIVITY_HOLD = 250;                 // Fast period lasts this long after last activity.
+        constexpr uint16_t STABLE_DELAY = 5000;                 // No activity this long backs off to IDLE_LOOP_PERIOD.
     }
 
     namespace DisplayTask
@@ -27,9 +38,11 @@ namespace Config
         constexpr bool INVERT_DET = true;   // If true then if diode on display is lit then digital low is delivered to MCU.
         constexpr bool INVERT_CTRL = false; // If true then digital low state is considered a button press on the display.
 
-        constexpr uint16_t LOOP_DELAY = 100;              // Delay between display task loop iterations.
-        constexpr uint16_t DISABLE_CHECK_DURATION = 2000; // For how long to check whether display is ON or OFF.
-        constexpr uint16_t STATE_TRANSITION_DELAY = 2000; // How long to wait for display to change state.
+        constexpr uint16_t LOOP_DELAY = 20;               // Delay between display state machine steps.
+        constexpr uint16_t DISABLE_CHECK_DURATION = 2000; // How long detection must be steadily lit to consider display ON.
+        constexpr uint16_t STATE_TRANSITION_DELAY = 2000; // Max time to wait for display to change state after click.
+        constexpr uint16_t CLICK_TIME = 400;              // How long simulated button is pressed.
+        constexpr uint16_t DET_GLITCH_TIME = 20;          // Detection levels shorter than this are ignored.
 
         namespace GPIO
         {
@@ -45,7 +58,7 @@ namespace Config
 
         constexpr uint8_t DEVICE_ID = 1; // Slave ID
 
-        constexpr unsigned long SERIAL_BAUD = 19200;
+        constexpr unsigned long SERIAL_BAUD = 19200; // Used instead of stored setting while power button is held at MCU start.
         constexpr unsigned long SERIAL_TIMEOUT = 50;
 
         namespace Coils // Coils (inputs to MCU)
@@ -67,11 +80,52 @@ namespace Config
             constexpr uint8_t AQ_SBC_HB_CNTR_ADDR = 0;
             constexpr uint8_t AQ_JOY1_LED_BRIGHTNESS_ADDR = 1;
             constexpr uint8_t AQ_JOY2_LED_BRIGHTNESS_ADDR = 2;
+            constexpr uint8_t AQ_DIAG_PAGE_ADDR = 3; // Diag page to expose in diag window.
+            constexpr uint8_t AQ_TRACE_ACK_ADDR = 4; // Sequence number of trace chunk consumed by SBC.
+            constexpr uint8_t AQ_GAMESEL_MAX_ADDR = 5; // Highest selectable slot, 0 keeps compiled default.
+
+            // Scene, written at once with FC16, applied when sequence number changes.
+            constexpr uint8_t AQ_SCENE_FLAGS_ADDR = 6;      // Bits: 0 display, 1 joy1, 2 joy2, 3 display last, 8..11 LED effect.
+            constexpr uint8_t AQ_SCENE_BRIGHTNESS_ADDR = 7; // Low byte joy1, high byte joy2.
+            constexpr uint8_t AQ_SCENE_DELAY_ADDR = 8;      // ms between display and other outputs.
+            constexpr uint8_t AQ_SCENE_SEQ_ADDR = 9;
+
+            // Slot profile upload block, stored to EEPROM when sequence number changes.
+            constexpr uint8_t AQ_PROFILE_FIRST_SLOT_ADDR = 10;
+            constexpr uint8_t AQ_PROFILE_COUNT_ADDR = 11; // Number of profiles in block.
+            constexpr uint8_t AQ_PROFILE_DATA_ADDR = 12;  // Flags (scene layout, bit 15 erases) and brightness per profile.
+            constexpr uint8_t PROFILE_BLOCK_SIZE = 4;     // Profiles per block.
+            constexpr uint8_t AQ_PROFILE_SEQ_ADDR = AQ_PROFILE_DATA_ADDR + 2 * PROFILE_BLOCK_SIZE;
+
+            // Runtime settings, one register per Settings::Field. Hold active values, stored when sequence number changes.
+            constexpr uint8_t AQ_SETTINGS_DATA_ADDR = 21;
+            constexpr uint8_t SETTINGS_SIZE = 13;
+            constexpr uint8_t AQ_SETTINGS_SEQ_ADDR = AQ_SETTINGS_DATA_ADDR + SETTINGS_SIZE;
+
+            constexpr uint8_t AQ_BOOT_PHASE_ADDR = 35; // Boot phase reached by SBC, MCU clears it when SBC is powered on.
+
+            // LED frame stream. Buffer n holds frames with seq % 2 == n, each frame is written at once with FC16.
+            constexpr uint8_t AQ_STREAM_INTERVAL_ADDR = 36; // ms between frames sent by SBC, 0 doesn't count late frames.
+            constexpr uint8_t AQ_STREAM_FRAME_ADDR = 37;    // Per buffer brightness (low byte joy1, high byte joy2), then seq.
+            constexpr uint8_t STREAM_FRAME_SIZE = 2;
+            constexpr uint8_t STREAM_FRAMES = 2;
         }
         namespace InputRegs // Input regs (outputs from MCU)
         {
             constexpr uint8_t AI_MCU_HB_CNTR_ADDR = 0;
             constexpr uint8_t AI_MCU_GAMESEL_ADDR = 1;
+            constexpr uint8_t AI_DIAG_PAGE_ADDR = 2;   // Page currently exposed in diag window.
+            constexpr uint8_t AI_DIAG_WINDOW_ADDR = 3; // First register of diag window.
+            constexpr uint8_t DIAG_WINDOW_SIZE = 12;
+            constexpr uint8_t AI_GAMESEL_PREVIEW_ADDR = 15; // Selector value not yet applied.
+            constexpr uint8_t AI_GAMESEL_DWELL_ADDR = 16;   // How long (ms, saturated) preview value didn't change.
+            constexpr uint8_t AI_SCENE_DONE_SEQ_ADDR = 17;  // Sequence number of last fully applied scene.
+            constexpr uint8_t AI_PROFILE_DONE_SEQ_ADDR = 18; // Sequence number of last stored profile block.
+            constexpr uint8_t AI_SETTINGS_DONE_SEQ_ADDR = 19; // Sequence number of last stored settings.
+            constexpr uint8_t AI_SETTINGS_STORED_ADDR = 20;   // 1 if settings come from EEPROM, 0 if compiled defaults are used.
+            constexpr uint8_t AI_STREAM_SEQ_ADDR = 21;        // Sequence number of last frame taken for presentation.
+            constexpr uint8_t AI_STREAM_DROPPED_ADDR = 22;    // Frames overwritten before MCU took them, wraps.
+            constexpr uint8_t AI_STREAM_LATE_ADDR = 23;       // Frames taken later than stream interval allows, wraps.
         }
     }
 
@@ -79,6 +133,8 @@ namespace Config
     {
         constexpr float BLINKING_RATIO = 0.1;       // Speed of blinking tied to delta time.
         constexpr float FAST_BLINKING_RATIO = 0.75; // Speed of fast blinking tied to delta time.
+        constexpr uint16_t STREAM_LATE_SLACK = 10;    // ms a frame may come after stream interval before it's late.
+        constexpr uint16_t STREAM_RESTART_GAP = 1000; // Frame after this long pause starts new stream, the gap isn't counted.
 
         namespace GPIO
         {
@@ -91,6 +147,17 @@ namespace Config
     {
         constexpr bool APPLY_BTN_LOGIC_INVERTED = true;
 
+        constexpr uint8_t ENCODER_REST_STATE = 0b11;               // Clk and dir levels when encoder sits in detent.
+        constexpr unsigned long ENCODER_ACCEL_INTERVAL = 60;       // Detents closer than this (ms) advance value by more than 1.
+        constexpr unsigned long ENCODER_ACCEL_IDLE_INTERVAL = 500; // Detent interval (ms) considered as idle encoder.
+        constexpr uint8_t ENCODER_ACCEL_MAX_STEP = 10;             // Value increment at top speed.
+        constexpr uint16_t ENCODER_ACCEL_RANGE_DETENTS = 32;       // At top speed whole range is walked in this many detents if it's more than MAX_STEP.
+
+        constexpr uint16_t DEFAULT_MAX_SLOT = 16;          // Highest selectable slot until SBC configures it.
+        constexpr unsigned long DISPLAY_PAGE_PERIOD = 700; // How long each page of 5 digit slot is shown.
+        constexpr uint8_t DISPLAY_STEP_PERIOD = 50;        // us between display clock edges, Timer2 compare period.
+        constexpr uint8_t DISPLAY_BRIGHTNESS = 7;          // 0..7
+
 #ifdef GAME_SELECTOR_ENCODER
         constexpr bool ENCODER_DIR_INVERTED = true;
 #else
@@ -102,6 +169,7 @@ namespace Config
             constexpr uint8_t APPLY_BTN = 12;
 
             constexpr uint8_t SELECTOR_NUM_PINS = 4; // Edit object declaration with more pins if changed!
+                                                     // Encoder uses [0] and [1] as clk and dir, [2] and [3] as display clk and dio.
             constexpr uint8_t SELECTOR_BITS[SELECTOR_NUM_PINS] = {A3, A2, A1, A0};
         }
     }
@@ -110,9 +178,16 @@ namespace Config
     {
         constexpr bool LOGIC_INVERTED = true;
 
+        constexpr bool HALT_DETECT = false;             // Set true if halt pin is wired with external pull-down, otherwise
+                                                        // shutdown always takes shutdown duration.
+        constexpr bool HALT_LOGIC_INVERTED = false;     // gpio-poweroff drives the pin high once halted.
+        constexpr unsigned long HALT_HB_SILENCE = 5000; // SBC heartbeat must be silent this long to trust halt pin.
+        constexpr unsigned long HALT_GUARD = 2000;      // Delay between detected halt and power cut.
+
         namespace GPIO
         {
             constexpr uint8_t RPI_PWR_CTRL = 5;
+            constexpr uint8_t RPI_HALTED = A4;
         }
     }
 
@@ -131,6 +206,7 @@ namespace Config
     {
         constexpr unsigned long CLICK_TIMEOUT = 500;
         constexpr unsigned long LONG_PRESS_MIN_TIME = 3000;
+        constexpr unsigned long DEBOUNCE_TIME = 10; // Level must be stable this long to be accepted.
 
         constexpr bool LOGIC_INVERTED = true;
 
@@ -140,6 +216,65 @@ namespace Config
         }
     }
 
+    namespace Profiles
+    {
+        constexpr uint16_t EEPROM_ADDR = 0; // First byte of profile table.
+        constexpr uint16_t COUNT = 64;      // Slots 0..COUNT-1 can have a profile.
+    }
+
+    namespace Settings
+    {
+        constexpr uint16_t EEPROM_ADDR = 256; // First byte of runtime settings block, after profile table.
+        constexpr uint8_t VERSION = 2;        // Bump when fields change, stored block is then replaced by defaults.
+    }
+
+    namespace Boot
+    {
+        constexpr uint16_t EEPROM_ADDR = 288;           // First byte of boot history, after runtime settings.
+        constexpr uint8_t HISTORY = 4;                  // Number of successful boots the timeout is derived from.
+        constexpr uint8_t TIMEOUT_MARGIN_PERCENT = 150; // Slowest recorded time of a phase is multiplied by this...
+        constexpr unsigned long TIMEOUT_SLACK = 15000;  // ...and this is added to get deadline of the phase.
+    }
+
+    namespace Resume
+    {
+        constexpr uint16_t EEPROM_ADDR = 320; // Last power and selector state, after boot history.
+
+        constexpr uint8_t MODE_OFF = 1;    // Wait for power button after MCU start.
+        constexpr uint8_t MODE_LAST = 2;   // Boot SBC right away if it was powered when MCU lost power.
+        constexpr uint8_t MODE_ALWAYS = 3; // Always boot SBC right away.
+
+        constexpr uint8_t MODE = MODE_LAST;   // Default of runtime setting.
+        constexpr bool WAKE_ON_SELECT = true; // Default of runtime setting, selecting slot in OFF boots SBC.
+    }
+
+    namespace Watchdog
+    {
+        constexpr unsigned long APP_DEADLINE = 1000;  // Max ms between App loop iterations.
+        constexpr unsigned long DISP_DEADLINE = 1000; // Max ms between display task steps.
+    }
+
+    namespace Power
+    {
+        constexpr unsigned long IDLE_DELAY = 10000; // OFF state without user activity this long blanks display and allows sleep.
+        constexpr unsigned long WAKE_HOLD = 50;     // Stay awake at least this long after wake so debouncers can finish.
+    }
+
+    namespace Tick
+    {
+        constexpr uint8_t PERIOD = 1; // ms between FreeRTOS ticks, 1, 2 or 4, only with TIMER2_TICK.
+    }
+
+    namespace Executor
+    {
+        constexpr uint8_t MAX_JOBS = 2; // Jobs of cooperative executor, or FreeRTOS tasks reported in its place.
+    }
+
+    namespace Trace
+    {
+        constexpr uint8_t RING_SIZE = 128; // Bytes of RAM for trace events, only with TRACE_ENABLED.
+    }
+
     namespace PWM
     {
         constexpr uint8_t NUM_MCU_PINS = 13;
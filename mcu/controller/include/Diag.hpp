@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Diagnostic pages exposed to SBC through MODBUS diag window.
+ */
+namespace Diag
+{
+    enum class Page : uint8_t
+    {
+        IDLE = 0, // Nothing exposed
+        MUTEX_STATE = 1, // acquisitions, contended, wait ticks, timeouts
+        MUTEX_LOG = 2,   // acquisitions, contended, wait ticks, timeouts
+        MUTEX_DISP = 3,  // acquisitions, contended, wait ticks, timeouts
+        TRACE = 4,       // see Trace::fill()
+        RUNTIME = 5,     // see Executor::freeRam(), then runs, max lateness (ms), max duration (us), free stack
+                         // of each executor job or FreeRTOS task
+        POWER = 6,       // sleeps, last and max wake to handled latency (us)
+        BOOT = 7,        // see Boot::Stats, phase, records, timeouts, last time and deadline of each phase,
+                         // shutdown time (all 100 ms), early and late power cuts, late frontends
+        WATCHDOG = 8,    // see Watchdog::Stats, faults, last task, its overdue ms, reset cause, warm reset
+        APP_STATES = 9,  // see App::Stats, entries and last dwell (s) of each state, last and max transition latency (us)
+        CADENCE = 10     // see Cadence::Stats, App loop period (ms), mode, seconds spent in each mode
+    };
+
+    /**
+     * @brief Callback that stores single value of a page at given window index.
+     */
+    typedef void (*Writer)(uint8_t idx, uint16_t val);
+
+    /**
+     * @brief Write contents of given page. Unknown pages write nothing.
+     */
+    void fill(Page page, Writer write);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "Mutex.hpp"
 
 /**
  * @brief Task to controll whether the display is on or off.
@@ -8,9 +9,20 @@ namespace Disp
 {
     /**
      * @brief Run task that controls display hardware via State.
+     * Runs init() and then step() every Config::DisplayTask::LOOP_DELAY.
     */
     void task(void *pvParameters __attribute__((unused)));
 
+    /**
+     * @brief Initialize display control hardware.
+    */
+    void init();
+
+    /**
+     * @brief Advance display state machine, never blocks.
+    */
+    void step();
+
     /**
      * @brief Get FreeRTOS stack size required to run this task.
     */
@@ -28,4 +40,14 @@ namespace Disp
      * @brief Remove force Off.
     */
     void removeForceOff();
+
+    /**
+     * @brief Contention of the mutex guarding force off flag.
+    */
+    Mutex::Stats getMutexStats();
+
+    /**
+     * @brief Record display detection edge. Call from PCINT2_vect, ignores changes of other pins.
+    */
+    void detEdge();
 }
\ No newline at end of file
@@ -1,81 +1,177 @@
 #pragma once
+#include <avr/pgmspace.h>
+#include "Pin.hpp"
+#include "Config.hpp"
 
+/**
+ * @brief Quadrature encoder decoded with state transition table.
+ *
+ * Invalid transitions (both channels changed) are ignored and bouncing
+ * between two neighbouring states cancels itself out, so no time based
+ * debouncing is needed. Detent is counted once the encoder is back in rest state.
+ * Fast spins advance value by more than one per detent.
+ *
+ * @tparam ClkPin Pin type of encoder channel A.
+ * @tparam DirPin Pin type of encoder channel B, inverted type reverses direction.
+ */
+template <class ClkPin, class DirPin>
 class Encoder
 {
 private:
-    bool BACKWARD = false;
-    bool FORWARD = true;
+    volatile uint16_t m_value = 0;
+    volatile uint16_t m_maxValue;
 
-    volatile uint8_t m_value = 0;
-    bool m_isDebouncing = false;
+    uint8_t m_state = 0;   // Previous AB levels.
+    int8_t m_quarters = 0; // Quarter steps since last rest state.
 
-    const uint8_t m_clkPin;
-    const uint8_t m_dirPin;
-    const uint8_t m_maxValue;
+    unsigned long m_stepStamp = 0;
+    volatile uint16_t m_stepInterval = Config::GameSelector::ENCODER_ACCEL_IDLE_INTERVAL; // Smoothed ms between detents.
 
-    const unsigned long m_debounceTime = 10;
-    unsigned long m_debounceStamp = 0;
-    ;
+    /**
+     * @brief Quarter step for given (previous AB << 2 | current AB).
+     */
+    static int8_t transition(uint8_t idx)
+    {
+        static const int8_t TABLE[16] PROGMEM = {
+            0, -1, 1, 0,
+            1, 0, 0, -1,
+            -1, 0, 0, 1,
+            0, 1, -1, 0};
 
-public:
-    Encoder(uint8_t clkPin, uint8_t dirPin, bool dirInverted, uint8_t maxValue)
-        : m_clkPin(clkPin), m_dirPin(dirPin), m_maxValue(maxValue)
+        return (int8_t)pgm_read_byte(&TABLE[idx]);
+    }
+
+    static uint8_t readState()
     {
-        if(dirInverted)
+        return (ClkPin::level() << 1) | DirPin::level();
+    }
+
+    /**
+     * @brief Value increment for detent that came given ms after previous one.
+     */
+    uint16_t stepSize(unsigned long interval, uint32_t range)
+    {
+        m_stepInterval = (3 * (uint32_t)m_stepInterval + min(interval, Config::GameSelector::ENCODER_ACCEL_IDLE_INTERVAL)) / 4;
+
+        if (m_stepInterval >= Config::GameSelector::ENCODER_ACCEL_INTERVAL)
         {
-            BACKWARD = true;
-            FORWARD = false;
+            return 1;
         }
+
+        // Big ranges must be walked in a flick too
+        uint32_t maxStep = max(range / Config::GameSelector::ENCODER_ACCEL_RANGE_DETENTS,
+                               (uint32_t)Config::GameSelector::ENCODER_ACCEL_MAX_STEP);
+
+        return 1 + (Config::GameSelector::ENCODER_ACCEL_INTERVAL - m_stepInterval) * (maxStep - 1) /
+                       Config::GameSelector::ENCODER_ACCEL_INTERVAL;
+    }
+
+    void step(bool forward, unsigned long interval)
+    {
+        uint32_t range = (uint32_t)m_maxValue + 1;
+        uint32_t size = stepSize(interval, range) % range;
+
+        uint32_t value = m_value;
+        value += forward ? size : range - size;
+        m_value = value % range;
+    }
+
+public:
+    Encoder(uint16_t maxValue)
+        : m_maxValue(maxValue)
+    {
     }
 
+    /**
+     * @brief Configure GPIO and enable pin change interrupts of both channels, ISR must call update().
+     */
     void init()
     {
-        pinMode(m_clkPin, INPUT);
-        pinMode(m_dirPin, INPUT);
+        ClkPin::input();
+        DirPin::input();
+
+        m_state = readState();
+
+        ClkPin::enableChangeInterrupt();
+        DirPin::enableChangeInterrupt();
     }
 
+    /**
+     * @brief Decode transition. Call from pin change ISR of encoder pins.
+     */
     void update()
     {
-        unsigned long currStamp = millis();
+        uint8_t state = readState();
+        int8_t quarter = transition((m_state << 2) | state);
+        m_state = state;
+
+        if (DirPin::INVERTED)
+        {
+            quarter = -quarter;
+        }
+        m_quarters += quarter;
 
-        if (m_isDebouncing)
+        if (state != Config::GameSelector::ENCODER_REST_STATE)
         {
-            if (currStamp - m_debounceStamp >= m_debounceTime)
-            {
-                m_isDebouncing = false;
-            }
-            else
-            {
-                return;
-            }
+            return;
         }
 
-        if (!digitalRead(m_clkPin))
+        // Less than half of detent is just a wiggle
+        if (m_quarters >= 2 || m_quarters <= -2)
+        {
+            unsigned long now = millis();
+            step(m_quarters > 0, now - m_stepStamp);
+            m_stepStamp = now;
+        }
+        m_quarters = 0;
+    }
+
+    uint16_t read()
+    {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t res = m_value;
+        SREG = sreg;
+
+        return res;
+    }
+
+    /**
+     * @brief Set current value, clamped to highest value.
+     */
+    void setValue(uint16_t value)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        m_value = min(value, (uint16_t)m_maxValue);
+        SREG = sreg;
+    }
+
+    /**
+     * @brief Change highest value, current value is clamped to it.
+     */
+    void setMaxValue(uint16_t maxValue)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        m_maxValue = maxValue;
+        if (m_value > maxValue)
         {
-            m_isDebouncing = true;
-            m_debounceStamp = currStamp;
-
-            if (digitalRead(m_dirPin) == FORWARD)
-            {
-                m_value++;
-                if (m_value > m_maxValue)
-                {
-                    m_value = 0;
-                }
-            }
-            else
-            {
-                m_value--;
-                if (m_value > m_maxValue)
-                {
-                    m_value = m_maxValue;
-                }
-            }
+            m_value = maxValue;
         }
+        SREG = sreg;
     }
 
-    uint8_t read()
+    /**
+     * @brief Smoothed time between recent detents in ms, capped by ENCODER_ACCEL_IDLE_INTERVAL.
+     */
+    uint16_t stepInterval()
     {
-        return m_value;
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t res = m_stepInterval;
+        SREG = sreg;
+
+        return res;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+#ifndef COOP_EXECUTOR
+#include <Arduino_FreeRTOS.h>
+#endif
+
+#if defined(COOP_EXECUTOR) && defined(TRACE_ENABLED)
+#error "Scheduler trace records FreeRTOS events, it can't be used with COOP_EXECUTOR"
+#endif
+
+/**
+ * @brief Cooperative replacement of FreeRTOS, enabled with COOP_EXECUTOR.
+ *
+ * Jobs are non-blocking step functions that keep their state between calls,
+ * all of them share the single Arduino stack. Timing comes from Timer0 millis() tick,
+ * CPU idles in sleep mode until next interrupt when no job is due.
+ */
+namespace Executor
+{
+    typedef void (*Job)();
+
+    /**
+     * @brief Timing of single job since boot. Runs wrap around, maximums saturate.
+     */
+    struct Stats
+    {
+        uint16_t runs = 0;
+        uint16_t maxLateness = 0; // ms the job started after it was due.
+        uint16_t maxDuration = 0; // us of the longest step.
+        uint16_t freeStack = 0;   // Stack never used by FreeRTOS task, jobs share Arduino stack.
+    };
+
+#ifdef COOP_EXECUTOR
+    /**
+     * @brief Run job every period ms, up to Config::Executor::MAX_JOBS.
+     */
+    void add(Job job, uint16_t period);
+
+    /**
+     * @brief Change period of added job, a job may change its own. Takes effect from its next due time.
+     */
+    void setPeriod(Job job, uint16_t period);
+
+    /**
+     * @brief Run due jobs and sleep until next interrupt. Call from loop().
+     */
+    void run();
+
+    /**
+     * @brief Get timing of job with given index, in order of add() calls.
+     */
+    Stats stats(uint8_t idx);
+#else
+    /**
+     * @brief Report FreeRTOS task in place of a job, up to Config::Executor::MAX_JOBS.
+     */
+    void addTask(TaskHandle_t task);
+
+    /**
+     * @brief Get free stack of task with given index, in order of addTask() calls. Timing stays zero.
+     */
+    Stats stats(uint8_t idx);
+#endif
+
+    /**
+     * @brief Unused RAM between heap and stack. In FreeRTOS build tasks run on static stacks,
+     * so it's free heap above heap end.
+     */
+    uint16_t freeRam();
+}
\ No newline at end of file
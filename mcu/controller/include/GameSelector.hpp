@@ -1,29 +1,66 @@
 #pragma once
 #include <Arduino.h>
 #include "Encoder.hpp"
-#include <TM1637Display.h>
+#include "SegmentDisplay.hpp"
 #include "Button.hpp"
 #include "Log.hpp"
 #include "Config.hpp"
 
+/**
+ * @brief Game selector that uses encoder to choose value and shows it on TM1637 display.
+ *
+ * @tparam ApplyPin Pin type of apply button, logical true means pressed.
+ * @tparam EncoderClkPin Pin type of encoder clock.
+ * @tparam EncoderDirPin Pin type of encoder direction, logical true means forward.
+ * @tparam DispClkPin Pin type of display clock.
+ * @tparam DispDioPin Pin type of display data.
+ */
+template <class ApplyPin, class EncoderClkPin, class EncoderDirPin, class DispClkPin, class DispDioPin>
 class GameSelectorEncoderDisplay
 {
 private:
-    Button m_applyBtn;
-    Encoder m_encoder;
-    TM1637Display m_display;
+    typedef SegmentDisplay<DispClkPin, DispDioPin> Display;
+
+    PinButton<ApplyPin> m_applyBtn;
+    Encoder<EncoderClkPin, EncoderDirPin> m_encoder;
+    Display m_display;
+
+    uint16_t m_savedValue = 0;
+
+    uint16_t m_previewValue = 0;
+    unsigned long m_previewStamp = 0;
+
+    bool m_blank = false;
+
+    /**
+     * @brief Show value on 4 digit display. Values above 9999 are shown in two
+     * alternating pages: ten thousands with dot and then remaining 4 digits.
+     */
+    void show(uint16_t value)
+    {
+        if (value <= 9999)
+        {
+            m_display.showNumber(value);
+            return;
+        }
 
-    uint8_t m_savedValue = 0;
-    const uint8_t m_numSlots;
+        if ((millis() / Config::GameSelector::DISPLAY_PAGE_PERIOD) % 2 == 0)
+        {
+            uint8_t segments[Display::DIGITS] = {0, 0, 0, (uint8_t)(Display::encodeDigit(value / 10000) | Display::SEG_DP)};
+            m_display.setSegments(segments);
+        }
+        else
+        {
+            m_display.showNumber(value % 10000);
+        }
+    }
 
 public:
-    GameSelectorEncoderDisplay(uint8_t applyPin, bool applyBtnInverse,
-                               uint8_t encoderClickPin, uint8_t encoderDirPin,
-                               uint8_t dispClk, uint8_t dispDio, uint8_t numSlots)
-        : m_applyBtn(applyPin, applyBtnInverse),
-          m_encoder(encoderClickPin, encoderDirPin, Config::GameSelector::ENCODER_DIR_INVERTED, numSlots),
-          m_display(dispClk, dispDio),
-          m_numSlots(numSlots)
+    /**
+     * @param maxSlot Highest selectable slot until setMaxSlot() is called.
+     */
+    GameSelectorEncoderDisplay(uint16_t maxSlot)
+        : m_encoder(maxSlot)
     {
     }
 
@@ -31,21 +68,84 @@ public:
     {
         m_applyBtn.init();
         m_encoder.init();
-        m_display.setBrightness(0x0f);
+        m_display.init();
     }
 
+    /**
+     * @brief Call from encoder pin change ISR.
+     */
     void encoderUpdate()
     {
         m_encoder.update();
     }
 
+    /**
+     * @brief Call from DISPLAY_TIMER_vect.
+     */
+    void displayStep()
+    {
+        m_display.step();
+    }
+
+    /**
+     * @brief Call from apply button pin change ISR.
+     */
+    void applyBtnEdge()
+    {
+        m_applyBtn.onEdge();
+    }
+
+    /**
+     * @brief Change highest selectable slot.
+     */
+    void setMaxSlot(uint16_t maxSlot)
+    {
+        m_encoder.setMaxValue(maxSlot);
+    }
+
+    /**
+     * @brief Restore applied value, e.g. after reset. Call after setMaxSlot().
+     */
+    void restore(uint16_t value)
+    {
+        m_encoder.setValue(value);
+        m_savedValue = m_encoder.read();
+        m_previewValue = m_savedValue;
+    }
+
+    /**
+     * @brief Turn display off, selection still works.
+     */
+    void setBlank(bool blank)
+    {
+        m_blank = blank;
+        m_display.setOn(!blank);
+    }
+
+    /**
+     * @brief Whether display has nothing left to send.
+     */
+    bool displayIdle()
+    {
+        return !m_display.busy();
+    }
+
     void update()
     {
-        uint8_t reading = m_encoder.read();
-        m_display.showNumberDec(reading, true);
+        uint16_t reading = m_encoder.read();
+        if (!m_blank)
+        {
+            show(reading);
+        }
+
+        if (reading != m_previewValue)
+        {
+            m_previewValue = reading;
+            m_previewStamp = millis();
+        }
 
         m_applyBtn.update();
-        
+
         if (m_applyBtn.clicked())
         {
             m_applyBtn.clearState();
@@ -54,97 +154,122 @@ public:
         }
     }
 
-    uint8_t read()
+    uint16_t read()
     {
         return m_savedValue;
     }
+
+    /**
+     * @brief Value currently chosen but not yet applied.
+     */
+    uint16_t preview()
+    {
+        return m_previewValue;
+    }
+
+    /**
+     * @brief How long preview value didn't change in ms, saturated at 0xFFFF.
+     */
+    uint16_t previewDwell()
+    {
+        return min(millis() - m_previewStamp, 0xFFFFUL);
+    }
 };
 
 /**
  * @brief Game selector that uses number of GPIO to convert them into value
  * that can be used to select game on SBC.
+ *
+ * @tparam ApplyPin Pin type of apply button, logical true means pressed.
+ * @tparam BitPins Pin types of selector bits, least significant first, logical true means shorted.
  */
-template <int numPins>
+template <class ApplyPin, class... BitPins>
 class GameSelector
 {
-    uint8_t m_pins[numPins];
+    typedef PinGroup<BitPins...> Bits;
+
+    PinButton<ApplyPin> m_applyBtn;
 
-    Button m_applyBtn;
+    uint16_t m_savedValue = 0;
 
-    const bool m_inverse; // Inverse GPIO logic.
+    uint16_t m_previewValue = 0;
+    unsigned long m_previewStamp = 0;
 
-    uint8_t m_savedValue = 0;
+public:
+    void init()
+    {
+        Bits::input();
+
+        m_savedValue = Bits::read();
+        m_previewValue = m_savedValue;
+
+        m_applyBtn.init();
+    }
 
     /**
-     * @brief Read selector's value constructed from binary reads of gamesel pins.
+     * @brief Call from apply button pin change ISR.
      */
-    uint8_t readPins()
+    void applyBtnEdge()
     {
-        uint8_t res = 0;
-        for (uint8_t i = 0; i < numPins; i++)
-        {
-            uint8_t val = digitalRead(m_pins[i]);
-            if (m_inverse)
-            {
-                val = !val;
-            }
-
-            res |= (val << i);
-        }
-        return res;
+        m_applyBtn.onEdge();
     }
 
-public:
     /**
-     * @brief Initialize selector hardware.
-     *
-     * @param inverse Whether digital 0 means that pin is shorted.
-     * @param applyPin Pin to apply game selector choice.
-     * @param ... numPins of GPIO.
-     *
+     * @brief Value is set by pins, nothing to restore.
      */
-    GameSelector(uint8_t applyPin, bool applyBtnInverse, bool inverse, ...)
-        : m_applyBtn(applyPin, applyBtnInverse), m_inverse(inverse)
+    void restore(uint16_t value __attribute__((unused)))
     {
-        va_list argList;
+    }
 
-        if (!numPins)
-        {
-            return;
-        }
+    /**
+     * @brief No display, nothing to blank.
+     */
+    void setBlank(bool blank __attribute__((unused)))
+    {
+    }
 
-        va_start(argList, inverse);
-        for (uint8_t i = 0; i < numPins; i++)
-        {
-            m_pins[i] = va_arg(argList, int);
-        }
-        va_end(argList);
+    bool displayIdle()
+    {
+        return true;
     }
 
-    void init()
+    void update()
     {
-        for (uint8_t i = 0; i < numPins; i++)
+        uint16_t reading = Bits::read();
+        if (reading != m_previewValue)
         {
-            pinMode(m_pins[i], INPUT);
+            m_previewValue = reading;
+            m_previewStamp = millis();
         }
 
-        m_savedValue = readPins();
-
-        m_applyBtn.init();
-    }
+        m_applyBtn.update();
 
-    void update()
-    {
         if (m_applyBtn.clicked())
         {
             m_applyBtn.clearState();
-            m_savedValue = readPins();
+            m_savedValue = reading;
             LOG_INFO("Game sel changed: " + String(m_savedValue));
         }
     }
 
-    uint8_t read()
+    uint16_t read()
     {
         return m_savedValue;
     }
+
+    /**
+     * @brief Value currently set on pins but not yet applied.
+     */
+    uint16_t preview()
+    {
+        return m_previewValue;
+    }
+
+    /**
+     * @brief How long preview value didn't change in ms, saturated at 0xFFFF.
+     */
+    uint16_t previewDwell()
+    {
+        return min(millis() - m_previewStamp, 0xFFFFUL);
+    }
 };
\ No newline at end of file
@@ -15,9 +15,12 @@ public:
         BLINKING,
         MANUAL,
         ALTERNATING_BLINKING,
-        FAST_BLINKING
+        FAST_BLINKING,
+        STREAM // Frames streamed by SBC.
     };
 
+    static constexpr uint8_t EFFECTS = static_cast<uint8_t>(Effect::STREAM) + 1; // STREAM must stay last.
+
 private:
     const uint8_t m_pin1;
     const uint8_t m_pin2;
@@ -27,6 +30,9 @@ private:
     uint8_t m_pwmVal1 = 0; // For manual control.
     uint8_t m_pwmVal2 = 0; // For manual control.
 
+    uint8_t m_frameVal1 = 0; // For streaming.
+    uint8_t m_frameVal2 = 0; // For streaming.
+
     Effect m_effect = Effect::OFF;
 
     unsigned long m_effectStamp = 0; // For delta calculation
@@ -61,6 +67,20 @@ public:
         m_pwmVal2 = val2;
     }
 
+    /**
+     * Whether current effect changes brightness on its own.
+     */
+    bool animating()
+    {
+        return m_effect == Effect::BLINKING || m_effect == Effect::ALTERNATING_BLINKING ||
+               m_effect == Effect::FAST_BLINKING;
+    }
+
+    /**
+     * Set brightness for each LED in STREAM mode, written right away so it shows from next PWM period.
+     */
+    void setFrame(uint8_t val1, uint8_t val2);
+
     /**
      * Set new effect for effector.
      */
@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "Mutex.hpp"
 
 
 #define DEBUG 0
@@ -49,4 +50,9 @@ namespace logger
 #if LOG_LEVEL != NONE
     void init(SoftwareSerial &stream);
 #endif
+
+    /**
+     * @brief Contention of the mutex guarding log stream. Zeroed if logging is disabled.
+     */
+    Mutex::Stats getMutexStats();
 }
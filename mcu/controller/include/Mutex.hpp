@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#ifndef COOP_EXECUTOR
+#include <Arduino_FreeRTOS.h>
+#include <semphr.h>
+
+#if configSUPPORT_STATIC_ALLOCATION != 1
+#error "Tasks and mutexes are statically allocated, set configSUPPORT_STATIC_ALLOCATION to 1"
+#endif
+#if INCLUDE_xSemaphoreGetMutexHolder != 1
+#error "Mutex probes its holder before fast path take, set INCLUDE_xSemaphoreGetMutexHolder to 1"
+#endif
+#endif
+
+/**
+ * @brief FreeRTOS mutex that keeps track of its own contention.
+ * Storage is part of the object, nothing is taken from heap.
+ *
+ * With COOP_EXECUTOR nothing can preempt the owner, take() always succeeds immediately
+ * and only acquisitions are counted.
+ */
+class Mutex
+{
+public:
+    /**
+     * @brief Usage counters. All of them wrap around, use deltas between reads.
+     */
+    struct Stats
+    {
+        uint16_t acquisitions = 0; // Successful takes.
+        uint16_t contended = 0;    // Successful takes that had to wait for the owner.
+        uint16_t waitTicks = 0;    // Ticks spent waiting (Tick::PERIOD_MS each), both for successful and timed out takes.
+        uint16_t timeouts = 0;     // Takes that gave up, the guarded operation was dropped.
+    };
+
+private:
+#ifndef COOP_EXECUTOR
+    StaticSemaphore_t m_buffer;
+    SemaphoreHandle_t m_handle;
+#endif
+    Stats m_stats;
+
+public:
+    /**
+     * @param traceName Name of this mutex in scheduler trace.
+     */
+    Mutex(char traceName);
+
+    /**
+     * @brief Take mutex with Config::Sync::MUTEX_TIMEOUT.
+     *
+     * @return True if mutex was taken and must be given back.
+     */
+    bool take();
+
+    void give();
+
+    /**
+     * @brief Get consistent copy of usage counters.
+     */
+    Stats stats();
+};
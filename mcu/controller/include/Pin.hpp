@@ -0,0 +1,253 @@
+#pragma once
+#include <Arduino.h>
+
+enum PinPort : uint8_t
+{
+    PORT_B,
+    PORT_C,
+    PORT_D
+};
+
+/**
+ * @brief Arduino Uno GPIO resolved at compile time.
+ *
+ * Port, bit and inversion are template parameters, so every access compiles
+ * to single sbi/cbi/sbis instruction instead of digitalRead/digitalWrite lookups.
+ * These instructions are atomic, no need to disable interrupts around them.
+ *
+ * @tparam pin Arduino pin number.
+ * @tparam inverted Whether logical true is digital 0.
+ */
+template <uint8_t pin, bool inverted = false>
+class Pin
+{
+    static_assert(pin < 20, "Only ATmega328P pins are supported");
+
+public:
+    static constexpr uint8_t NUMBER = pin;
+    static constexpr bool INVERTED = inverted;
+    static constexpr PinPort PORT = pin < 8 ? PORT_D : (pin < 14 ? PORT_B : PORT_C);
+    static constexpr uint8_t BIT = pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14);
+    static constexpr uint8_t MASK = 1 << BIT;
+
+    static volatile uint8_t &inReg()
+    {
+        return PORT == PORT_D ? PIND : (PORT == PORT_B ? PINB : PINC);
+    }
+
+    static volatile uint8_t &outReg()
+    {
+        return PORT == PORT_D ? PORTD : (PORT == PORT_B ? PORTB : PORTC);
+    }
+
+    static volatile uint8_t &modeReg()
+    {
+        return PORT == PORT_D ? DDRD : (PORT == PORT_B ? DDRB : DDRC);
+    }
+
+    static volatile uint8_t &changeMaskReg()
+    {
+        return PORT == PORT_D ? PCMSK2 : (PORT == PORT_B ? PCMSK0 : PCMSK1);
+    }
+
+    static void output()
+    {
+        modeReg() |= MASK;
+    }
+
+    static void input()
+    {
+        modeReg() &= ~MASK;
+        outReg() &= ~MASK;
+    }
+
+    static void inputPullup()
+    {
+        modeReg() &= ~MASK;
+        outReg() |= MASK;
+    }
+
+    /**
+     * @brief Raw digital level of the pin.
+     */
+    static bool level()
+    {
+        return inReg() & MASK;
+    }
+
+    /**
+     * @brief Logical state, inversion applied.
+     */
+    static bool read()
+    {
+        return level() != inverted;
+    }
+
+    /**
+     * @brief Set logical state, inversion applied.
+     */
+    static void write(bool val)
+    {
+        if (val != inverted)
+        {
+            outReg() |= MASK;
+        }
+        else
+        {
+            outReg() &= ~MASK;
+        }
+    }
+
+    static void toggle()
+    {
+        inReg() = MASK;
+    }
+
+    /**
+     * @brief Enable pin change interrupt of this pin.
+     * PCINT0_vect handles PORT_B, PCINT1_vect PORT_C and PCINT2_vect PORT_D.
+     */
+    static void enableChangeInterrupt()
+    {
+        uint8_t sreg = SREG;
+        cli();
+        changeMaskReg() |= MASK;
+        PCICR |= 1 << (PORT == PORT_B ? PCIE0 : (PORT == PORT_C ? PCIE1 : PCIE2));
+        SREG = sreg;
+    }
+};
+
+template <uint8_t idx, class... Pins>
+struct PinGroupImpl;
+
+template <uint8_t idx>
+struct PinGroupImpl<idx>
+{
+    static constexpr bool contiguous(PinPort port __attribute__((unused)), uint8_t firstBit __attribute__((unused)))
+    {
+        return true;
+    }
+
+    static constexpr uint8_t invertMask()
+    {
+        return 0;
+    }
+
+    static constexpr bool usesPort(PinPort port __attribute__((unused)))
+    {
+        return false;
+    }
+
+    static void input() {}
+
+    static uint8_t gather(uint8_t b __attribute__((unused)), uint8_t c __attribute__((unused)), uint8_t d __attribute__((unused)))
+    {
+        return 0;
+    }
+};
+
+template <uint8_t idx, class P, class... Rest>
+struct PinGroupImpl<idx, P, Rest...>
+{
+    typedef PinGroupImpl<idx + 1, Rest...> Next;
+
+    /**
+     * @brief Whether this and following pins sit on given port at bits firstBit + idx.
+     */
+    static constexpr bool contiguous(PinPort port, uint8_t firstBit)
+    {
+        return P::PORT == port && P::BIT == firstBit + idx && Next::contiguous(port, firstBit);
+    }
+
+    static constexpr uint8_t invertMask()
+    {
+        return (P::INVERTED ? (1 << idx) : 0) | Next::invertMask();
+    }
+
+    static constexpr bool usesPort(PinPort port)
+    {
+        return P::PORT == port || Next::usesPort(port);
+    }
+
+    static void input()
+    {
+        P::input();
+        Next::input();
+    }
+
+    /**
+     * @brief Collect raw bits of pins from port snapshots.
+     */
+    static uint8_t gather(uint8_t b, uint8_t c, uint8_t d)
+    {
+        uint8_t port = P::PORT == PORT_B ? b : (P::PORT == PORT_C ? c : d);
+        return (((port >> P::BIT) & 1) << idx) | Next::gather(b, c, d);
+    }
+};
+
+/**
+ * @brief Group of pins read as single binary value, first pin is the least significant bit.
+ *
+ * Pins that are contiguous on one port are read with single port read and shift,
+ * otherwise each used port is read once and bits are gathered from these snapshots.
+ */
+template <class First, class... Rest>
+class PinGroup
+{
+    typedef PinGroupImpl<0, First, Rest...> Impl;
+
+public:
+    static constexpr uint8_t COUNT = 1 + sizeof...(Rest);
+    static constexpr uint8_t MASK = (1 << COUNT) - 1;
+    static constexpr bool CONTIGUOUS = Impl::contiguous(First::PORT, First::BIT);
+
+    static_assert(COUNT <= 8, "Group value is 8 bit");
+
+    static void input()
+    {
+        Impl::input();
+    }
+
+    /**
+     * @brief Single sample of group value, inversion applied.
+     */
+    static uint8_t sample()
+    {
+        uint8_t res;
+
+        if (CONTIGUOUS)
+        {
+            res = (First::inReg() >> First::BIT) & MASK;
+        }
+        else
+        {
+            res = Impl::gather(Impl::usesPort(PORT_B) ? PINB : 0,
+                               Impl::usesPort(PORT_C) ? PINC : 0,
+                               Impl::usesPort(PORT_D) ? PIND : 0);
+        }
+
+        return res ^ Impl::invertMask();
+    }
+
+    /**
+     * @brief Sample group until two consecutive samples match so the value isn't torn by transition.
+     *
+     * @param maxSamples Give up and return last sample after this many samples.
+     */
+    static uint8_t read(uint8_t maxSamples = 8)
+    {
+        uint8_t prev = sample();
+
+        for (uint8_t i = 1; i < maxSamples; i++)
+        {
+            uint8_t curr = sample();
+            if (curr == prev)
+            {
+                break;
+            }
+            prev = curr;
+        }
+
+        return prev;
+    }
+};
\ No newline at end of file
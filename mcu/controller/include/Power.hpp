@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Power down sleep while there is nothing to do.
+ *
+ * idle() runs from loop(), which is FreeRTOS idle task hook (or executor loop with COOP_EXECUTOR).
+ * While App allows it, CPU enters SLEEP_MODE_PWR_DOWN with soft PWM, ADC and watchdog tick stopped.
+ * Any enabled pin change wakes it: power and apply buttons, encoder, display detection
+ * and UART RX start bit. Time doesn't advance in millis() while sleeping.
+ */
+namespace Power
+{
+    /**
+     * @brief Sleep counters. Sleeps wrap around, latencies saturate.
+     */
+    struct Stats
+    {
+        uint16_t sleeps = 0;
+        uint16_t lastLatency = 0; // us from wake until App handled it.
+        uint16_t maxLatency = 0;
+    };
+
+    /**
+     * @brief Allow sleeping, App decides when outputs are idle.
+     */
+    void setSleepAllowed(bool allowed);
+
+    /**
+     * @brief Sleep if allowed and last wake was handled. Call from loop().
+     */
+    void idle();
+
+    /**
+     * @brief Mark wake as handled by App, call at the end of App loop iteration.
+     */
+    void handled();
+
+    Stats stats();
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Per-slot output profiles cached in EEPROM, uploaded by SBC.
+ *
+ * Lets MCU set up joys and LEDs as soon as a slot is applied, before SBC loads it.
+ */
+namespace Profiles
+{
+    struct Profile
+    {
+        bool joy1Enable = false;
+        bool joy2Enable = false;
+        uint8_t effect = 0; // 0 manual brightness, otherwise LightEffectors::Effect + 1.
+        uint8_t joy1Brightness = 0;
+        uint8_t joy2Brightness = 0;
+    };
+
+    /**
+     * @brief Read profile of given slot.
+     *
+     * @return False if slot has no valid profile.
+     */
+    bool get(uint16_t slot, Profile &profile);
+
+    /**
+     * @brief Store profile of given slot, only changed bytes are written. Blocks for few ms per changed byte.
+     */
+    void store(uint16_t slot, const Profile &profile);
+
+    /**
+     * @brief Invalidate profile of given slot.
+     */
+    void erase(uint16_t slot);
+}
\ No newline at end of file
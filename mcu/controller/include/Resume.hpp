@@ -0,0 +1,30 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Power and selector state kept in EEPROM so MCU can resume after mains power returns.
+ *
+ * Setters write only when the value changed.
+ */
+namespace Resume
+{
+    struct Snapshot
+    {
+        bool powered = false; // SBC was on or booting.
+        uint16_t slot = 0;    // Applied selector value.
+        uint16_t maxSlot = 0; // Highest slot configured by SBC, 0 if never configured.
+    };
+
+    /**
+     * @brief Load stored state.
+     *
+     * @return False if there is no valid state, defaults are used then.
+     */
+    bool init();
+
+    Snapshot get();
+
+    void setPowered(bool powered);
+    void setSlot(uint16_t slot);
+    void setMaxSlot(uint16_t maxSlot);
+}
\ No newline at end of file
@@ -1,46 +1,67 @@
 #pragma once
 #include <Arduino.h>
+#include "Pin.hpp"
+#include "Config.hpp"
 
 /**
  * @brief Simple SBC control.
+ *
+ * @tparam PinT Pin type, logical true means the SBC is on.
  */
+template <class PinT>
 class SBC
 {
-    bool OFF = false;
-    bool ON = true;
-
-    const uint8_t m_pin;
-
 public:
     /**
-     * @brief Initialize hardware to control SBC.
-     *
-     * @param pin Pin to use.
-     * @param activeLow Whether digital 0 means the SBC is on and 1 that it's OFF.
+     * @param on Initial state, pin is set before it becomes output so there's no glitch.
      */
-    SBC(uint8_t pin, bool activeLow) : m_pin(pin)
+    void init(bool on = false)
     {
-        if (activeLow)
-        {
-            OFF = true;
-            ON = false;
-        }
+        PinT::write(on);
+        PinT::output();
     }
 
-    void init()
+    void on()
     {
-        pinMode(m_pin, OUTPUT);
+        PinT::write(true);
+    }
 
-        off();
+    void off()
+    {
+        PinT::write(false);
     }
+};
 
-    void on()
+/**
+ * @brief SBC control with halt detection.
+ *
+ * SBC asserts halt pin once it's safe to cut its power (gpio-poweroff overlay, active high).
+ * The line needs an external pull-down, SBC pin is 3.3 V only so MCU must not pull it up.
+ * Disabled by default, boards without the wire would read a floating pin.
+ *
+ * @tparam PinT Pin type, logical true means the SBC is on.
+ * @tparam HaltPinT Pin type, logical true means the SBC halted.
+ */
+template <class PinT, class HaltPinT>
+class HaltingSBC : public SBC<PinT>
+{
+public:
+    void init(bool on = false)
     {
-        digitalWrite(m_pin, ON);
+        // Pin is left untouched if it isn't wired
+        if (Config::SBC::HALT_DETECT)
+        {
+            HaltPinT::input(); // Pulled down externally, SBC pin is 3.3 V only.
+        }
+
+        SBC<PinT>::init(on);
     }
 
-    void off()
+    /**
+     * @brief Whether SBC reports halt, always false if halt pin isn't wired.
+     */
+    bool halted()
     {
-        digitalWrite(m_pin, OFF);
+        return Config::SBC::HALT_DETECT && HaltPinT::read();
     }
 };
\ No newline at end of file
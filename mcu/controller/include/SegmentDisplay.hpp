@@ -0,0 +1,361 @@
+#pragma once
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include "Pin.hpp"
+#include "Config.hpp"
+#ifdef TIMER2_TICK
+#include "Tick.hpp"
+
+#define DISPLAY_TIMER_vect TIMER2_COMPB_vect
+#else
+#define DISPLAY_TIMER_vect TIMER2_COMPA_vect
+#endif
+
+/**
+ * @brief 4 digit TM1637 display driven in background.
+ *
+ * Caller only copies new frame into buffer, frame is sent only when it differs
+ * from the last one. Bits are shifted out by Timer2 compare interrupt, one clock
+ * edge per interrupt, so nothing blocks the caller. Timer2 interrupt is enabled
+ * only while frame is being sent.
+ *
+ * Timer2 runs in CTC mode and compare A interrupt steps the display. With TIMER2_TICK
+ * compare A is FreeRTOS tick, display then uses compare B moved forward by step period
+ * on each interrupt, wrapping at tick TOP.
+ *
+ * Lines are open drain with external pull-ups: low is driven output, high is released input.
+ *
+ * @tparam ClkPin Pin type of display clock.
+ * @tparam DioPin Pin type of display data.
+ */
+template <class ClkPin, class DioPin>
+class SegmentDisplay
+{
+public:
+    static constexpr uint8_t DIGITS = 4;
+    static constexpr uint8_t SEG_DP = 0x80;
+
+private:
+    static constexpr uint8_t CMD_DATA = 0x40;    // Write data, auto increment address.
+    static constexpr uint8_t CMD_ADDRESS = 0xC0; // Start at first digit.
+    static constexpr uint8_t CMD_CONTROL = 0x80; // Display off, brightness in lower 3 bits.
+    static constexpr uint8_t CONTROL_ON = 0x08;
+
+    // Bytes of frame transfer: data command, address command with digits, control command.
+    static constexpr uint8_t TX_SIZE = DIGITS + 3;
+    static constexpr uint8_t TX_DIGITS = 2; // Index of first digit.
+
+#ifdef TIMER2_TICK
+    static constexpr uint16_t TIMER_TICKS = Config::GameSelector::DISPLAY_STEP_PERIOD / Tick::TIMER_US > 0
+                                                ? Config::GameSelector::DISPLAY_STEP_PERIOD / Tick::TIMER_US
+                                                : 1;
+    static_assert(TIMER_TICKS < Tick::TIMER_COUNTS, "Display step period must be shorter than tick");
+#else
+    static constexpr uint16_t TIMER_TICKS = Config::GameSelector::DISPLAY_STEP_PERIOD * 2; // Timer2 runs at 2 MHz.
+    static_assert(TIMER_TICKS >= 1 && TIMER_TICKS <= 256, "Display step period doesn't fit Timer2");
+#endif
+
+    enum class Step : uint8_t
+    {
+        IDLE,
+        START,
+        BIT_CLK_LOW,
+        BIT_DATA,
+        BIT_CLK_HIGH,
+        ACK_CLK_LOW,
+        ACK_CLK_HIGH,
+        ACK_END,
+        STOP_DIO_LOW,
+        STOP_CLK_HIGH,
+        STOP_DIO_HIGH
+    };
+
+    // Shared with ISR.
+    volatile uint8_t m_next[DIGITS] = {0, 0, 0, 0};
+    volatile bool m_nextOn = true;
+    volatile bool m_dirty = false;
+    volatile bool m_busy = false;
+
+    uint8_t m_frame[DIGITS] = {0, 0, 0, 0}; // Last frame handed to ISR.
+    bool m_on = true;
+
+    // ISR only.
+    uint8_t m_tx[TX_SIZE];
+    uint8_t m_txIdx = 0;
+    uint8_t m_bit = 0;
+    Step m_step = Step::IDLE;
+
+    static void low(bool clk)
+    {
+        if (clk)
+        {
+            ClkPin::output();
+        }
+        else
+        {
+            DioPin::output();
+        }
+    }
+
+    static void release(bool clk)
+    {
+        if (clk)
+        {
+            ClkPin::input();
+        }
+        else
+        {
+            DioPin::input();
+        }
+    }
+
+    /**
+     * @brief Whether transfer is closed with stop condition after given byte.
+     */
+    static bool endsTransfer(uint8_t idx)
+    {
+        return idx == 0 || idx == TX_DIGITS + DIGITS - 1 || idx == TX_SIZE - 1;
+    }
+
+    /**
+     * @brief Enable step interrupt, first one comes after step period. Called with interrupts disabled.
+     */
+    static void startTimer()
+    {
+#ifdef TIMER2_TICK
+        OCR2B = (TCNT2 + TIMER_TICKS) % Tick::TIMER_COUNTS;
+        TIFR2 = 1 << OCF2B;
+        TIMSK2 |= 1 << OCIE2B;
+#else
+        TCNT2 = 0;
+        TIFR2 = 1 << OCF2A;
+        TIMSK2 |= 1 << OCIE2A;
+#endif
+    }
+
+    static void stopTimer()
+    {
+#ifdef TIMER2_TICK
+        TIMSK2 &= ~(1 << OCIE2B);
+#else
+        TIMSK2 &= ~(1 << OCIE2A);
+#endif
+    }
+
+    /**
+     * @brief Schedule next step interrupt. Called from step interrupt.
+     */
+    static void nextTimer()
+    {
+#ifdef TIMER2_TICK
+        OCR2B = (OCR2B + TIMER_TICKS) % Tick::TIMER_COUNTS;
+#endif
+    }
+
+    /**
+     * @brief Hand current frame to ISR, start sending unless it's already busy.
+     */
+    void send()
+    {
+        uint8_t sreg = SREG;
+        cli();
+        for (uint8_t i = 0; i < DIGITS; i++)
+        {
+            m_next[i] = m_frame[i];
+        }
+        m_nextOn = m_on;
+        m_dirty = true;
+
+        if (!m_busy)
+        {
+            m_busy = true;
+            load();
+            startTimer();
+        }
+        SREG = sreg;
+    }
+
+    /**
+     * @brief Copy pending frame into transmit buffer. Called with interrupts disabled.
+     */
+    void load()
+    {
+        m_tx[0] = CMD_DATA;
+        m_tx[1] = CMD_ADDRESS;
+        for (uint8_t i = 0; i < DIGITS; i++)
+        {
+            m_tx[TX_DIGITS + i] = m_next[i];
+        }
+        m_tx[TX_SIZE - 1] = CMD_CONTROL | (m_nextOn ? CONTROL_ON : 0) | (Config::GameSelector::DISPLAY_BRIGHTNESS & 0x07);
+
+        m_dirty = false;
+        m_txIdx = 0;
+        m_step = Step::START;
+    }
+
+public:
+    void init()
+    {
+        release(true);
+        release(false);
+
+#ifndef TIMER2_TICK
+        uint8_t sreg = SREG;
+        cli();
+        TCCR2A = 1 << WGM21; // CTC
+        TCCR2B = 1 << CS21;  // 8 prescaler
+        OCR2A = TIMER_TICKS - 1;
+        TIMSK2 &= ~(1 << OCIE2A);
+        SREG = sreg;
+#endif
+    }
+
+    /**
+     * @brief Segments of decimal digit.
+     */
+    static uint8_t encodeDigit(uint8_t digit)
+    {
+        static const uint8_t DIGIT_SEGMENTS[10] PROGMEM = {
+            0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+        return pgm_read_byte(&DIGIT_SEGMENTS[digit % 10]);
+    }
+
+    /**
+     * @brief Show segments, digits left to right. Nothing is sent if they didn't change.
+     */
+    void setSegments(const uint8_t segments[DIGITS])
+    {
+        if (memcmp(m_frame, segments, DIGITS) == 0)
+        {
+            return;
+        }
+        memcpy(m_frame, segments, DIGITS);
+
+        send();
+    }
+
+    /**
+     * @brief Turn display off keeping its segments, or back on.
+     */
+    void setOn(bool on)
+    {
+        if (on == m_on)
+        {
+            return;
+        }
+        m_on = on;
+
+        send();
+    }
+
+    /**
+     * @brief Whether a frame is being sent.
+     */
+    bool busy()
+    {
+        return m_busy;
+    }
+
+    /**
+     * @brief Show number with leading zeros, lower 4 digits only.
+     */
+    void showNumber(uint16_t value)
+    {
+        uint8_t segments[DIGITS];
+        for (int8_t i = DIGITS - 1; i >= 0; i--)
+        {
+            segments[i] = encodeDigit(value % 10);
+            value /= 10;
+        }
+
+        setSegments(segments);
+    }
+
+    /**
+     * @brief Advance transfer by one clock edge. Call from DISPLAY_TIMER_vect.
+     */
+    void step()
+    {
+        nextTimer();
+
+        switch (m_step)
+        {
+        case Step::IDLE:
+            break;
+        case Step::START:
+            low(false);
+            m_bit = 0;
+            m_step = Step::BIT_CLK_LOW;
+            break;
+        case Step::BIT_CLK_LOW:
+            low(true);
+            m_step = Step::BIT_DATA;
+            break;
+        case Step::BIT_DATA:
+            if (m_tx[m_txIdx] & (1 << m_bit))
+            {
+                release(false);
+            }
+            else
+            {
+                low(false);
+            }
+            m_step = Step::BIT_CLK_HIGH;
+            break;
+        case Step::BIT_CLK_HIGH:
+            release(true);
+            m_bit++;
+            m_step = m_bit < 8 ? Step::BIT_CLK_LOW : Step::ACK_CLK_LOW;
+            break;
+        case Step::ACK_CLK_LOW:
+            low(true);
+            release(false); // Display pulls data low as ack, it isn't checked.
+            m_step = Step::ACK_CLK_HIGH;
+            break;
+        case Step::ACK_CLK_HIGH:
+            release(true);
+            m_step = Step::ACK_END;
+            break;
+        case Step::ACK_END:
+            low(true);
+            low(false);
+            if (endsTransfer(m_txIdx))
+            {
+                m_step = Step::STOP_DIO_LOW;
+            }
+            else
+            {
+                m_bit = 0;
+                m_step = Step::BIT_CLK_LOW;
+            }
+            m_txIdx++;
+            break;
+        case Step::STOP_DIO_LOW:
+            low(false);
+            m_step = Step::STOP_CLK_HIGH;
+            break;
+        case Step::STOP_CLK_HIGH:
+            release(true);
+            m_step = Step::STOP_DIO_HIGH;
+            break;
+        case Step::STOP_DIO_HIGH:
+            release(false);
+            if (m_txIdx < TX_SIZE)
+            {
+                m_step = Step::START;
+            }
+            else if (m_dirty)
+            {
+                load();
+            }
+            else
+            {
+                m_step = Step::IDLE;
+                m_busy = false;
+                stopTimer();
+            }
+            break;
+        }
+    }
+};
\ No newline at end of file
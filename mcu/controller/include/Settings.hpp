@@ -0,0 +1,70 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Runtime tunable timing and behaviour kept in EEPROM, SBC reads and updates it over MODBUS.
+ *
+ * Block is loaded at boot and validated with CRC, compiled defaults from Config.hpp
+ * are used if it's missing or broken. Each field is one 16 bit MODBUS register.
+ */
+namespace Settings
+{
+    enum class Field : uint8_t
+    {
+        BOOT_TIMEOUT = 0,           // s
+        SHUTDOWN_DURATION = 1,      // s
+        SBC_HB_CHECK_PERIOD = 2,    // ms
+        SBC_HB_MAX_RETRIES = 3,     //
+        SERIAL_BAUD = 4,            // 100 baud, standard rates 1200..115200 only, applied after reset
+        BLINKING_RATIO = 5,         // 1/1000
+        FAST_BLINKING_RATIO = 6,    // 1/1000
+        DISABLE_CHECK_DURATION = 7, // ms
+        STATE_TRANSITION_DELAY = 8, // ms
+        CLICK_TIME = 9,             // ms
+        CLICK_TIMEOUT = 10,         // ms
+        RESUME_MODE = 11,           // Config::Resume::MODE_*
+        WAKE_ON_SELECT = 12         // 1 off, 2 on
+    };
+
+    constexpr uint8_t COUNT = 13;
+
+    /**
+     * @brief Load block from EEPROM. Call before anything reads settings.
+     */
+    void init();
+
+    /**
+     * @brief Raw value of field in its register unit.
+     */
+    uint16_t get(Field field);
+
+    /**
+     * @brief Validate, apply and store all fields. Zero or out of range value selects compiled default.
+     * Only changed bytes are written, blocks for few ms per changed byte.
+     */
+    void store(const uint16_t values[COUNT]);
+
+    /**
+     * @brief Whether active values come from valid EEPROM block.
+     */
+    bool stored();
+
+    /**
+     * @brief Use compiled serial baud until reset, stored value is kept. Recovers SBC locked out by wrong baud.
+     */
+    void useDefaultBaud();
+
+    unsigned long bootTimeout();
+    unsigned long shutdownDuration();
+    unsigned long sbcHbCheckPeriod();
+    uint8_t sbcHbMaxRetries();
+    unsigned long serialBaud();
+    float blinkingRatio();
+    float fastBlinkingRatio();
+    unsigned long disableCheckDuration();
+    unsigned long stateTransitionDelay();
+    unsigned long clickTime();
+    unsigned long clickTimeout();
+    uint8_t resumeMode();
+    bool wakeOnSelect();
+}
\ No newline at end of file
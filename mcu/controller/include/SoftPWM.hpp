@@ -17,6 +17,16 @@ void SoftPWMAttach(uint8_t pin);
 void SoftPWMDetach(uint8_t pin);
 
 /**
- * @brief Set new pwm value to given pin.
+ * @brief Set new pwm value to given pin, it takes effect at start of next PWM period.
 */
-void SoftPwmWrite(uint8_t pin, uint8_t val);
\ No newline at end of file
+void SoftPwmWrite(uint8_t pin, uint8_t val);
+
+/**
+ * @brief Stop PWM timer interrupt and drive attached pins low.
+*/
+void SoftPwmSuspend();
+
+/**
+ * @brief Restart PWM timer interrupt after SoftPwmSuspend().
+*/
+void SoftPwmResume();
\ No newline at end of file
@@ -1,11 +1,87 @@
 #pragma once
 #include <Arduino.h>
+#include "Mutex.hpp"
 
 /**
  * @brief Global state, thread safe.
 */
 namespace State
 {
+    /**
+     * @brief Output set requested by SBC in single write.
+     */
+    struct Scene
+    {
+        uint16_t seq = 0;
+        bool display = false;
+        bool joy1Enable = false;
+        bool joy2Enable = false;
+        bool displayLast = false; // Apply display after other outputs instead of before.
+        uint8_t effect = 0;       // 0 manual brightness, otherwise LightEffectors::Effect + 1.
+        uint8_t joy1Brightness = 0;
+        uint8_t joy2Brightness = 0;
+        uint16_t stepDelay = 0; // ms between display and other outputs.
+    };
+
+    /**
+     * @brief Fields of register image shared with MODBUS server, values are kept in register form.
+     *
+     * Fields up to BOOT_PHASE are written by SBC as well, the rest only by MCU.
+     */
+    enum class Field : uint8_t
+    {
+        SHUTDOWN_FLAG,
+        DISPLAY_STATE,
+        JOY1_ENABLE,
+        JOY2_ENABLE,
+        JOY1_BRIGHTNESS,
+        JOY2_BRIGHTNESS,
+        SELECTOR_MAX_SLOT,
+        BOOT_PHASE,
+        SHUTDOWN_REQ,
+        SELECTOR_VALUE,
+        SELECTOR_PREVIEW,
+        SELECTOR_DWELL
+    };
+
+    constexpr uint8_t FIELDS = 12;
+
+    struct Image
+    {
+        uint16_t values[FIELDS];
+        uint16_t dirty; // Bit per field written by MCU since last sync.
+    };
+
+    /**
+     * @brief Callback that pushes dirty fields to MODBUS server and pulls the ones SBC writes.
+     */
+    typedef void (*Sync)(Image &image);
+
+    /**
+     * @brief Run sync on register image under single mutex take, dirty bits are cleared afterwards.
+     */
+    void sync(Sync fn);
+
+    /**
+     * @brief LED frame streamed by SBC.
+     */
+    struct Frame
+    {
+        uint16_t seq = 0;
+        uint8_t joy1Brightness = 0;
+        uint8_t joy2Brightness = 0;
+    };
+
+    // Scene received from SBC
+    void setScene(const Scene &scene);
+    // Get scene received from SBC, returns false if there's no new one
+    bool takeScene(Scene &scene);
+
+    // Frame received from SBC, replaces one not taken yet
+    void setFrame(const Frame &frame);
+    // Get frame received from SBC, returns false if there's no new one
+    bool takeFrame(Frame &frame);
+
     // MCU request shutdown of the SBC
     bool getShutdownRequest();
     // MCU request shutdown of the SBC
@@ -31,6 +107,23 @@ namespace State
     uint8_t getJoy2Brightness();
     void setJoy2Brightness(uint8_t val);
 
-    uint8_t getSelectorValue();
-    void setSelectorValue(uint8_t val);
+    uint16_t getSelectorValue();
+    void setSelectorValue(uint16_t val);
+
+    // Selector value chosen but not applied yet
+    uint16_t getSelectorPreview();
+    // How long preview didn't change in ms
+    uint16_t getSelectorPreviewDwell();
+    void setSelectorPreview(uint16_t val, uint16_t dwell);
+
+    // Highest selectable slot requested by SBC, 0 if not configured
+    uint16_t getSelectorMaxSlot();
+    void setSelectorMaxSlot(uint16_t val);
+
+    // Boot phase reported by SBC, see Boot::Phase
+    uint8_t getBootPhase();
+    void setBootPhase(uint8_t phase);
+
+    // Contention of the mutex guarding above values
+    Mutex::Stats getMutexStats();
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include "Config.hpp"
+
+#if defined(TIMER2_TICK) && defined(COOP_EXECUTOR)
+#error "TIMER2_TICK drives FreeRTOS tick, it can't be used with COOP_EXECUTOR"
+#endif
+
+/**
+ * @brief FreeRTOS tick source.
+ *
+ * Port ticks from watchdog at ~15 ms. With TIMER2_TICK, Timer2 compare A takes over
+ * at Config::Tick::PERIOD and enters the port tick handler directly, watchdog interrupt
+ * is disabled. Timer1 (SoftPWM) is left untouched, Timer2 compare B stays free for display.
+ */
+namespace Tick
+{
+#ifdef TIMER2_TICK
+    constexpr uint16_t PERIOD_MS = Config::Tick::PERIOD;
+
+    static_assert(PERIOD_MS == 1 || PERIOD_MS == 2 || PERIOD_MS == 4, "Timer2 tick supports 1, 2 or 4 ms");
+
+    // 8 us resolution for 1 ms, 16 us for longer periods so TOP fits 8 bits.
+    constexpr uint16_t TIMER_PRESCALER = PERIOD_MS == 1 ? 128 : 256;
+    constexpr uint16_t TIMER_US = TIMER_PRESCALER / (F_CPU / 1000000UL);
+    constexpr uint16_t TIMER_COUNTS = PERIOD_MS * 1000U / TIMER_US;
+#else
+    constexpr uint16_t PERIOD_MS = portTICK_PERIOD_MS;
+#endif
+
+    /**
+     * @brief Convert ms to ticks like pdMS_TO_TICKS, but at least one tick so short delays still yield.
+     */
+    constexpr TickType_t fromMs(uint16_t ms)
+    {
+        return ms >= PERIOD_MS ? ms / PERIOD_MS : 1;
+    }
+
+    /**
+     * @brief Switch tick source. Call from first task that runs, after scheduler started the watchdog.
+     */
+    void init();
+
+    /**
+     * @brief Stop tick interrupt so it doesn't wake CPU from power down. Tick count stands still meanwhile.
+     */
+    void suspend();
+
+    void resume();
+}
\ No newline at end of file
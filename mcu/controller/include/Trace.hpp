@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include "TraceHooks.h"
+#include "Diag.hpp"
+
+/**
+ * @brief Recorder of FreeRTOS scheduling events, enabled with TRACE_ENABLED.
+ *
+ * Events are stored in RAM ring as [type, arg, delta] where delta is
+ * LEB128 encoded time since previous event in 16us units.
+ * Ring is drained by SBC in chunks through Diag::Page::TRACE.
+ */
+namespace Trace
+{
+#ifdef TRACE_ENABLED
+    /**
+     * @brief Record queue events of given object under given name.
+     */
+    void nameObject(void *object, char name);
+
+    /**
+     * @brief Release current chunk if SBC acknowledged its sequence number and expose next one.
+     */
+    void acknowledge(uint16_t seq);
+
+    /**
+     * @brief Write current chunk as: sequence number, length in bytes, dropped events, packed bytes.
+     */
+    void fill(Diag::Writer write);
+#else
+    inline void nameObject(void *object __attribute__((unused)), char name __attribute__((unused))) {}
+    inline void acknowledge(uint16_t seq __attribute__((unused))) {}
+    inline void fill(Diag::Writer write __attribute__((unused))) {}
+#endif
+}
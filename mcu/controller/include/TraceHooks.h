@@ -0,0 +1,38 @@
+#pragma once
+/**
+ * FreeRTOS trace macros. Force included into every translation unit (kernel too)
+ * by the trace build environment, so it has to stay plain C.
+ */
+#if defined(TRACE_ENABLED) && !defined(__ASSEMBLER__)
+#include <stdint.h>
+
+#define TRACE_EVT_SWITCH 1          // arg: first char of task name now running
+#define TRACE_EVT_DELAY 2           // arg: first char of task name that went to sleep
+#define TRACE_EVT_GIVE 3            // arg: traced object name
+#define TRACE_EVT_TAKE 4            // arg: traced object name
+#define TRACE_EVT_TAKE_BLOCKED 5    // arg: traced object name
+#define TRACE_EVT_TAKE_TIMEOUT 6    // arg: traced object name
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void traceSwitchedIn(uint8_t task);
+    void traceTaskEvent(uint8_t type, uint8_t task);
+    void traceObjectEvent(uint8_t type, void *object);
+#ifdef __cplusplus
+}
+#endif
+
+// Switch out is implied by next switch in, only changes of running task are recorded.
+#define traceTASK_SWITCHED_IN() traceSwitchedIn((uint8_t)pxCurrentTCB->pcTaskName[0])
+#define traceTASK_SWITCHED_OUT()
+#define traceTASK_DELAY() traceTaskEvent(TRACE_EVT_DELAY, (uint8_t)pxCurrentTCB->pcTaskName[0])
+#define traceTASK_DELAY_UNTIL(x) traceTaskEvent(TRACE_EVT_DELAY, (uint8_t)pxCurrentTCB->pcTaskName[0])
+
+#define traceQUEUE_SEND(pxQueue) traceObjectEvent(TRACE_EVT_GIVE, (void *)(pxQueue))
+#define traceQUEUE_RECEIVE(pxQueue) traceObjectEvent(TRACE_EVT_TAKE, (void *)(pxQueue))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) traceObjectEvent(TRACE_EVT_TAKE_BLOCKED, (void *)(pxQueue))
+#define traceQUEUE_RECEIVE_FAILED(pxQueue) traceObjectEvent(TRACE_EVT_TAKE_TIMEOUT, (void *)(pxQueue))
+
+#endif
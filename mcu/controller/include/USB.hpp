@@ -5,4 +5,5 @@
 /**
  * @brief Simple USB switch controller.
 */
-typedef SBC USB;
\ No newline at end of file
+template <class PinT>
+using USB = SBC<PinT>;
\ No newline at end of file
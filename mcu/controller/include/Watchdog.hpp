@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * @brief Task supervisor feeding hardware watchdog, with fault record kept over reset.
+ *
+ * Each task checks in once per loop iteration. Supervisor runs from loop() (idle hook)
+ * and feeds the watchdog only while all check-ins are younger than their deadline. A task that
+ * misses its deadline is recorded and MCU is reset right away; a task hogging CPU starves
+ * loop() and the watchdog resets MCU by itself.
+ *
+ * Record and last outputs live in .noinit RAM, so after any reset with SBC powered App
+ * restores outputs instead of starting from OFF and the running game isn't interrupted.
+ *
+ * Hardware watchdog needs the WDT free, i.e. TIMER2_TICK or COOP_EXECUTOR. With WDT driven
+ * FreeRTOS tick deadlines are also checked from the tick hook, so a task hogging CPU and
+ * starving loop() still misses its deadline and resets MCU.
+ */
+namespace Watchdog
+{
+    enum class Task : uint8_t
+    {
+        APP = 0,
+        DISP = 1,
+        HARDWARE = 0xFF // Reset by watchdog timeout, no task was recorded.
+    };
+
+    constexpr uint8_t TASKS = 2;
+
+    /**
+     * @brief App outputs restored after reset. No member initializers, they would
+     * make the .noinit record initialized at startup.
+     */
+    struct Outputs
+    {
+        uint8_t appState;
+        bool display;
+        bool joy1Enable;
+        bool joy2Enable;
+        uint8_t joy1Brightness;
+        uint8_t joy2Brightness;
+    };
+
+    /**
+     * @brief Faults since power on, they survive reset but not power loss.
+     */
+    struct Stats
+    {
+        uint16_t faults = 0;
+        uint8_t lastTask = 0;     // Task of last fault.
+        uint16_t lastOverdue = 0; // ms the task was late, 0 for hardware timeout.
+        uint8_t resetCause = 0;   // MCUSR of last reset, 0 if bootloader cleared it.
+        bool warm = false;        // Record of previous run survived, App restores its outputs.
+    };
+
+    /**
+     * @brief Read record of previous run. Call before outputs are initialized.
+     *
+     * @param outputs Set to outputs before reset.
+     * @return Whether this is a reset of running MCU and outputs should be restored.
+     */
+    bool init(Outputs &outputs);
+
+    /**
+     * @brief Arm hardware watchdog, call when tick source is final.
+     */
+    void start();
+
+    /**
+     * @brief Task finished loop iteration.
+     */
+    void checkIn(Task task);
+
+    /**
+     * @brief Keep outputs to restore after reset, call once per App loop iteration.
+     */
+    void setOutputs(const Outputs &outputs);
+
+    /**
+     * @brief Check deadlines and feed watchdog. Call from loop().
+     */
+    void supervise();
+
+    /**
+     * @brief Check deadlines without hardware watchdog. Call from FreeRTOS tick hook.
+     */
+    void tick();
+
+    /**
+     * @brief Stop hardware watchdog for power down, it would reset MCU while sleeping.
+     */
+    void suspend();
+
+    void resume();
+
+    Stats stats();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+"""PlatformIO target that reports SRAM use per module from linker map and checks free RAM margin"""
+import os
+import re
+from collections import defaultdict
+
+Import("env")  # pylint: disable=undefined-variable # noqa: F821
+
+SRAM_SIZE = 2048  # ATmega328P
+
+# Input section line, size and object may be wrapped to next line when section name is long
+INPUT_SECTION = re.compile(r"^ (\.(?:data|bss|noinit)\S*|COMMON)\s*(?:(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*))?$")
+WRAPPED_TAIL = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*)$")
+
+
+def module_name(obj: str) -> str:
+    """Turn object path (or archive(member)) into short module name"""
+    member = re.search(r"\(([^)]+)\)$", obj)
+    if member:
+        return os.path.basename(obj[:member.start()]) + ":" + member.group(1)
+
+    name = os.path.basename(obj)
+    return name[:-2] if name.endswith(".o") else name
+
+
+def parse_map(path: str) -> dict:
+    """Sum .data and .bss (.noinit and COMMON count as bss) input sections per module"""
+    usage = defaultdict(lambda: {"data": 0, "bss": 0})
+
+    with open(path, "r", encoding="utf8", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    # Memory map follows discarded sections and memory configuration
+    try:
+        start = lines.index("Linker script and memory map")
+    except ValueError:
+        start = 0
+
+    i = start
+    while i < len(lines):
+        m = INPUT_SECTION.match(lines[i])
+        i += 1
+        if not m:
+            continue
+
+        section, addr, size, obj = m.groups()
+        if addr is None and i < len(lines):
+            tail = WRAPPED_TAIL.match(lines[i])
+            if not tail:
+                continue
+            addr, size, obj = tail.groups()
+            i += 1
+
+        size = int(size, 16)
+        # Load addresses of .data in flash aren't SRAM, SRAM starts at 0x800000 in avr-ld
+        if size == 0 or int(addr, 16) < 0x800000:
+            continue
+
+        kind = "data" if section.startswith(".data") else "bss"
+        usage[module_name(obj)][kind] += size
+
+    return usage
+
+
+def ram_report(target, source, env):  # pylint: disable=unused-argument
+    """Print per module table and fail if free SRAM is below margin"""
+    map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+    if not os.path.isfile(map_path):
+        print("Linker map %s not found, build first" % map_path)
+        return 1
+
+    margin = int(env.GetProjectOption("custom_ram_margin", "256"))
+    usage = parse_map(map_path)
+
+    print("%-40s %7s %7s %7s" % ("module", "data", "bss", "total"))
+    total_data = 0
+    total_bss = 0
+    for name, use in sorted(usage.items(), key=lambda item: -(item[1]["data"] + item[1]["bss"])):
+        print("%-40s %7d %7d %7d" % (name, use["data"], use["bss"], use["data"] + use["bss"]))
+        total_data += use["data"]
+        total_bss += use["bss"]
+
+    static = total_data + total_bss
+    free = SRAM_SIZE - static
+    print("%-40s %7d %7d %7d" % ("total", total_data, total_bss, static))
+    print("Task stacks and RTOS objects are static, they're counted in bss of their modules.")
+    print("Left for main stack (setup, ISRs before scheduler start) and heap (String): %d bytes" % free)
+
+    if free < margin:
+        print("Free SRAM %d is below margin %d" % (free, margin))
+        return 1
+
+    return 0
+
+
+env.AddCustomTarget(  # noqa: F821
+    name="ram_report",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=ram_report,
+    title="RAM report",
+    description="SRAM use per module from linker map, fails below custom_ram_margin")
+
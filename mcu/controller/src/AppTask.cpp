@@ -1,6 +1,8 @@
 #include "AppTask.hpp"
+#ifndef COOP_EXECUTOR
 #include <Arduino_FreeRTOS.h>
-#include <PinChangeInterrupt.h>
+#include "Tick.hpp"
+#endif
 #include "Button.hpp"
 #include "SBC.hpp"
 #include "USB.hpp"
@@ -11,39 +13,58 @@
 #include "Comm.hpp"
 #include "Config.hpp"
 #include "DisplayTask.hpp"
+#include "Pin.hpp"
+#include "Profiles.hpp"
+#include "Settings.hpp"
+#include "Boot.hpp"
+#include "Resume.hpp"
+#include "Watchdog.hpp"
+#include "Power.hpp"
+#include "Cadence.hpp"
+#include "Executor.hpp"
 
 namespace
 {
-    Button g_pwrBtn(Config::PwrButton::GPIO::RPI_PWR_BTN, Config::PwrButton::LOGIC_INVERTED);
-    SBC g_sbc(Config::SBC::GPIO::RPI_PWR_CTRL, Config::SBC::LOGIC_INVERTED);
+    typedef Pin<Config::PwrButton::GPIO::RPI_PWR_BTN, Config::PwrButton::LOGIC_INVERTED> PwrBtnPin;
+    typedef Pin<Config::GameSelector::GPIO::APPLY_BTN, Config::GameSelector::APPLY_BTN_LOGIC_INVERTED> ApplyBtnPin;
+
+    // Pin change vectors below are bound to these ports
+    static_assert(ApplyBtnPin::PORT == PORT_B, "Apply button must be handled by PCINT0_vect");
+    static_assert(PwrBtnPin::PORT == PORT_D, "Power button must be handled by PCINT2_vect"); // Shared with display detection
 
-    USB g_joy1(Config::Joy::GPIO::JOY1_CTRL, Config::Joy::LOGIC_INVERTED);
-    USB g_joy2(Config::Joy::GPIO::JOY2_CTRL, Config::Joy::LOGIC_INVERTED);
+    PinButton<PwrBtnPin> g_pwrBtn;
+    HaltingSBC<Pin<Config::SBC::GPIO::RPI_PWR_CTRL, Config::SBC::LOGIC_INVERTED>,
+               Pin<Config::SBC::GPIO::RPI_HALTED, Config::SBC::HALT_LOGIC_INVERTED>>
+        g_sbc;
+
+    USB<Pin<Config::Joy::GPIO::JOY1_CTRL, Config::Joy::LOGIC_INVERTED>> g_joy1;
+    USB<Pin<Config::Joy::GPIO::JOY2_CTRL, Config::Joy::LOGIC_INVERTED>> g_joy2;
 
     LightEffectors g_ledCtrl(Config::LightEffector::GPIO::JOY1_LED,
                              Config::LightEffector::GPIO::JOY2_LED);
 
 #ifdef GAME_SELECTOR_ENCODER
-    GameSelectorEncoderDisplay g_gameSelector(
-        Config::GameSelector::GPIO::APPLY_BTN,
-        Config::GameSelector::APPLY_BTN_LOGIC_INVERTED,
-        Config::GameSelector::GPIO::SELECTOR_BITS[0],
-        Config::GameSelector::GPIO::SELECTOR_BITS[1],
-        Config::GameSelector::GPIO::SELECTOR_BITS[2],
-        Config::GameSelector::GPIO::SELECTOR_BITS[3],
-        Config::GameSelector::GPIO::SELECTOR_NUM_PINS *Config::GameSelector::GPIO::SELECTOR_NUM_PINS);
+    typedef Pin<Config::GameSelector::GPIO::SELECTOR_BITS[0]> EncoderClkPin;
+    typedef Pin<Config::GameSelector::GPIO::SELECTOR_BITS[1], Config::GameSelector::ENCODER_DIR_INVERTED> EncoderDirPin;
+
+    static_assert(EncoderClkPin::PORT == PORT_C && EncoderDirPin::PORT == PORT_C,
+                  "Encoder must be handled by PCINT1_vect");
+
+    GameSelectorEncoderDisplay<ApplyBtnPin, EncoderClkPin, EncoderDirPin,
+                               Pin<Config::GameSelector::GPIO::SELECTOR_BITS[2]>,
+                               Pin<Config::GameSelector::GPIO::SELECTOR_BITS[3]>>
+        g_gameSelector(Config::GameSelector::DEFAULT_MAX_SLOT);
 #else
-    GameSelector<Config::GameSelector::GPIO::SELECTOR_NUM_PINS> g_gameSelector(
-        Config::GameSelector::GPIO::APPLY_BTN,
-        Config::GameSelector::APPLY_BTN_LOGIC_INVERTED,
-        Config::GameSelector::SELECTORS_LOGIC_INVERTED,
-        Config::GameSelector::GPIO::SELECTOR_BITS[0],
-        Config::GameSelector::GPIO::SELECTOR_BITS[1],
-        Config::GameSelector::GPIO::SELECTOR_BITS[2],
-        Config::GameSelector::GPIO::SELECTOR_BITS[3]);
+    GameSelector<
+        ApplyBtnPin,
+        Pin<Config::GameSelector::GPIO::SELECTOR_BITS[0], Config::GameSelector::SELECTORS_LOGIC_INVERTED>,
+        Pin<Config::GameSelector::GPIO::SELECTOR_BITS[1], Config::GameSelector::SELECTORS_LOGIC_INVERTED>,
+        Pin<Config::GameSelector::GPIO::SELECTOR_BITS[2], Config::GameSelector::SELECTORS_LOGIC_INVERTED>,
+        Pin<Config::GameSelector::GPIO::SELECTOR_BITS[3], Config::GameSelector::SELECTORS_LOGIC_INVERTED>>
+        g_gameSelector;
 #endif
 
-    enum class AppState
+    enum class AppState : uint8_t
     {
         OFF,
         BOOTING,
@@ -52,200 +73,571 @@ namespace
         ERROR
     } g_state;
 
-    unsigned long g_bootStamp;
+    static_assert(static_cast<uint8_t>(AppState::ERROR) + 1 == App::STATES, "App::STATES must match AppState");
+
+    /**
+     * @brief Inputs of state machine, POLL is raised every loop iteration.
+     */
+    enum class Event : uint8_t
+    {
+        POLL,
+        CLICK,
+        LONG_PRESS,
+        SELECT // Selector preview moved since player was last active.
+    };
+
+    typedef bool (*Guard)();
+    typedef void (*Action)();
+
+    /**
+     * @brief Row of transition table. First row of current state and event whose guard passes is taken.
+     */
+    struct Transition
+    {
+        AppState from;
+        Event event;
+        Guard guard; // nullptr always passes.
+        AppState to;
+        Action action; // Runs between exit of old and entry of new state, may be nullptr.
+    };
+
+    /**
+     * @brief Hooks of single state, all may be nullptr.
+     */
+    struct StateHooks
+    {
+        Action enter;
+        Action exit;
+        Action run; // Every loop iteration the state lasts.
+    };
+
+    unsigned long g_stateStamp = 0; // Last transition.
+    App::Stats g_stats;
+
+    bool g_haltDetected = false;
+    unsigned long g_haltStamp = 0;
+    bool g_forceShutdown = false; // Long press was handled, wait for release.
+
+    unsigned long g_activityStamp = 0; // Last user activity in OFF state.
+    uint16_t g_activityPreview = 0;
+
+    uint16_t g_appliedSlot = 0; // Selector value whose profile was applied last.
+
+    State::Scene g_scene;
+    bool g_sceneStepPending = false; // Second step of g_scene waits for its delay.
+    unsigned long g_sceneStepStamp = 0;
 }
 
 namespace App
 {
     void task(void *pvParameters __attribute__((unused)));
+    void init();
+    void step();
+    Stats stats();
+
+    /**
+     * @brief Take first transition of current state matching event.
+     *
+     * @return Whether a transition was taken.
+     */
+    bool dispatch(Event event);
+
+    /**
+     * @brief Dispatch button and selector events.
+     *
+     * @return Whether a transition was taken.
+     */
+    bool dispatchInput();
+
+    /**
+     * @brief Exit current state, run transition action and enter new state. Timed into stats.
+     */
+    void transition(AppState to, Action action);
+
+    /**
+     * @brief Enter state without leaving current one, used at startup.
+     */
+    void enter(AppState s);
+
+    StateHooks hooks(AppState s);
+
+    void enterOff();
+    void enterBooting();
+    void enterConnected();
+    void enterShutdown();
+    void enterError();
+    void exitConnected();
+
+    /**
+     * @brief Let SBC go, entry of states without running daemon.
+     *
+     * @param shutdownRequest Whether SBC is asked to shut down.
+     */
+    void releaseSbc(bool shutdownRequest);
+
+    void runBooting();
+    void runConnected();
+    void runShutdown();
+
+    /**
+     * @brief Blank display and allow sleep after a while without user activity. Only in OFF state.
+     */
+    void handleIdlePower();
+
+    bool disconnected();
+
+    /**
+     * @brief SBC halted and power cut guard passed.
+     */
+    bool haltConfirmed();
+    bool shutdownElapsed();
+
+    void logBooting();
+    void logSelectWake();
+    void bootSucceeded();
+    void bootFailed();
+    void logButtonShutdown();
+    void logSbcShutdown();
+    void logDisconnected();
+    void haltedShutdown();
+    void timedShutdown();
+    void logForceShutdown();
+
+    /**
+     * @brief Restore selector from EEPROM.
+     */
+    void restoreSelector();
+
+    /**
+     * @brief Choose first state according to resume mode.
+     */
+    void resume();
+
+    /**
+     * @brief Continue with outputs MCU had before reset.
+     */
+    void recover(const Watchdog::Outputs &outputs);
+
+    /**
+     * @brief Keep current outputs for recovery after reset.
+     */
+    void saveOutputs();
+
+    /**
+     * @brief Highest selectable slot, configured by SBC or last configured one.
+     */
+    uint16_t maxSlot();
+
+    /**
+     * @brief Execute scenes requested by SBC. Only in connected state.
+     */
+    void handleScene();
+
+    /**
+     * @brief Apply cached profile as soon as selector value is applied. Only in connected state.
+     */
+    void handleProfile();
+    void applySceneDisplay();
+    void applySceneJoys();
+
+    /**
+     * @brief Set LED effect from SBC code, 0 is manual brightness, otherwise LightEffectors::Effect + 1.
+     * Unknown codes keep current effect.
+     */
+    void setLedEffect(uint8_t code);
 
-    void setAppState(AppState s);
+    void logHighwater();
 
-    void handleForceShutdown();
-    void handleOffState();
-    void handleBootState();
-    void handleConnectedState();
-    void handleShutdownState();
-    void handleErrorState();
+#ifndef COOP_EXECUTOR
+    void task(void *pvParameters __attribute__((unused)))
+    {
+        // Highest priority task runs first
+        Tick::init();
+        init();
 
-    // Only for encoder based selector
-    void selectorClkISRhandler();
+        while (true)
+        {
+            step();
 
-    void logHighwater();
+            vTaskDelay(Tick::fromMs(Cadence::period()));
+        }
+    }
+#endif
 
-    void task(void *pvParameters __attribute__((unused)))
+    void init()
     {
-        bool forceShutdown = false;
+        // Outputs are set to their state before reset right away, so SBC and joys stay powered
+        Watchdog::Outputs outputs;
+        bool recovered = Watchdog::init(outputs) && outputs.appState != static_cast<uint8_t>(AppState::OFF) &&
+                         outputs.appState <= static_cast<uint8_t>(AppState::ERROR);
+        bool joysOn = recovered && static_cast<AppState>(outputs.appState) == AppState::CONNECTED;
 
-        g_sbc.init();
+        g_sbc.init(recovered);
         g_pwrBtn.init();
-        g_joy1.init();
-        g_joy2.init();
+        g_joy1.init(joysOn && outputs.joy1Enable);
+        g_joy2.init(joysOn && outputs.joy2Enable);
         g_ledCtrl.init();
         g_gameSelector.init();
 
+        Settings::init(); // Comm needs serial baud
+
+        // Button held through reset gives no click or long press, so recovery doesn't change power state
+        if (!recovered && PwrBtnPin::read())
+        {
+            Settings::useDefaultBaud();
+        }
+        Boot::init();
+        Comm::init();
+
+        restoreSelector();
+        if (recovered)
+        {
+            recover(outputs);
+        }
+        else
+        {
+            resume();
+        }
+
+        Watchdog::start();
+    }
+
+    void restoreSelector()
+    {
+        Resume::init();
+
 #ifdef GAME_SELECTOR_ENCODER
-        attachPinChangeInterrupt(
-            digitalPinToPCINT(
-                Config::GameSelector::GPIO::SELECTOR_BITS[0]),
-            selectorClkISRhandler, CHANGE);
+        g_gameSelector.setMaxSlot(maxSlot());
 #endif
+        g_gameSelector.restore(Resume::get().slot);
+    }
 
-        Comm::init();
+    void resume()
+    {
+        uint8_t mode = Settings::resumeMode();
+        if (mode == Config::Resume::MODE_ALWAYS || (mode == Config::Resume::MODE_LAST && Resume::get().powered))
+        {
+            enter(AppState::BOOTING);
+
+            LOG_INFO(F("Resume"));
+            return;
+        }
 
-        setAppState(AppState::OFF);
+        enter(AppState::OFF);
+    }
 
-        while (true)
+    void recover(const Watchdog::Outputs &outputs)
+    {
+        // MODBUS registers were reset as well, SBC doesn't rewrite them
+        Comm::setDisplayState(outputs.display);
+        Comm::setJoys(outputs.joy1Enable, outputs.joy2Enable, outputs.joy1Brightness, outputs.joy2Brightness);
+
+        AppState state = static_cast<AppState>(outputs.appState);
+        if (state == AppState::CONNECTED)
         {
-            Comm::update();
-            g_pwrBtn.update();
-            g_ledCtrl.update();
-            g_gameSelector.update();
+            Comm::assumeConnected();
+        }
+        enter(state);
 
-            State::setSelectorValue(g_gameSelector.read());
+        LOG_ERROR(F("Recovered"));
+    }
 
-            if (g_pwrBtn.longPressed() && !forceShutdown)
-            {
-                g_pwrBtn.clearState();
-                forceShutdown = true;
-                handleForceShutdown();
-            }
-            else if (!g_pwrBtn.longPressed() && forceShutdown)
+    void saveOutputs()
+    {
+        Watchdog::Outputs outputs;
+        outputs.appState = static_cast<uint8_t>(g_state);
+        outputs.display = State::getDisplayState();
+        outputs.joy1Enable = State::getJoy1Enable();
+        outputs.joy2Enable = State::getJoy2Enable();
+        outputs.joy1Brightness = State::getJoy1Brightness();
+        outputs.joy2Brightness = State::getJoy2Brightness();
+
+        Watchdog::setOutputs(outputs);
+    }
+
+    uint16_t maxSlot()
+    {
+        uint16_t res = State::getSelectorMaxSlot();
+        if (res)
+        {
+            Resume::setMaxSlot(res);
+        }
+        else
+        {
+            res = Resume::get().maxSlot;
+        }
+
+        return res ? res : Config::GameSelector::DEFAULT_MAX_SLOT;
+    }
+
+    void step()
+    {
+        Comm::update();
+        g_pwrBtn.update();
+
+        State::Frame frame;
+        if (State::takeFrame(frame))
+        {
+            g_ledCtrl.setFrame(frame.joy1Brightness, frame.joy2Brightness);
+        }
+        g_ledCtrl.update();
+#ifdef GAME_SELECTOR_ENCODER
+        g_gameSelector.setMaxSlot(maxSlot());
+#endif
+        g_gameSelector.update();
+
+        // State still holds preview of previous iteration
+        if (g_pwrBtn.pressed() || g_gameSelector.preview() != State::getSelectorPreview())
+        {
+            Cadence::activity();
+        }
+
+        State::setSelectorValue(g_gameSelector.read());
+        Resume::setSlot(g_gameSelector.read());
+        State::setSelectorPreview(g_gameSelector.preview(), g_gameSelector.previewDwell());
+
+        if (g_pwrBtn.longPressed() && !g_forceShutdown)
+        {
+            g_pwrBtn.clearState();
+            g_forceShutdown = true;
+            dispatch(Event::LONG_PRESS);
+        }
+        else if (!g_pwrBtn.longPressed() && g_forceShutdown)
+        {
+            g_forceShutdown = false;
+        }
+
+        g_ledCtrl.setManualBrightness(State::getJoy1Brightness(), State::getJoy2Brightness());
+
+        // State left on input doesn't run, new one runs next iteration
+        if (!dispatchInput())
+        {
+            Action run = hooks(g_state).run;
+            if (run)
             {
-                forceShutdown = false;
+                run();
             }
+            dispatch(Event::POLL);
+        }
+
+        g_pwrBtn.clearState();
+
+        saveOutputs();
+        Watchdog::checkIn(Watchdog::Task::APP);
+        Power::handled();
+
+        Cadence::update(g_ledCtrl.animating());
+#ifdef COOP_EXECUTOR
+        Executor::setPeriod(step, Cadence::period());
+#endif
+
+        // logHighwater();
+    }
+
+    Stats stats()
+    {
+        return g_stats;
+    }
 
-            g_ledCtrl.setManualBrightness(State::getJoy1Brightness(), State::getJoy2Brightness());
+    bool dispatch(Event event)
+    {
+        static constexpr Transition TRANSITIONS[] PROGMEM = {
+            {AppState::OFF, Event::CLICK, nullptr, AppState::BOOTING, logBooting},
+            {AppState::OFF, Event::SELECT, Settings::wakeOnSelect, AppState::BOOTING, logSelectWake},
+            {AppState::BOOTING, Event::POLL, Comm::connected, AppState::CONNECTED, bootSucceeded},
+            {AppState::BOOTING, Event::POLL, Boot::timedOut, AppState::ERROR, bootFailed},
+            {AppState::CONNECTED, Event::CLICK, nullptr, AppState::SHUTTING_DOWN, logButtonShutdown},
+            {AppState::CONNECTED, Event::POLL, State::getShutdownFlag, AppState::SHUTTING_DOWN, logSbcShutdown},
+            {AppState::CONNECTED, Event::POLL, disconnected, AppState::ERROR, logDisconnected},
+            {AppState::SHUTTING_DOWN, Event::POLL, haltConfirmed, AppState::OFF, haltedShutdown},
+            {AppState::SHUTTING_DOWN, Event::POLL, shutdownElapsed, AppState::OFF, timedShutdown},
+            {AppState::ERROR, Event::CLICK, nullptr, AppState::OFF, logButtonShutdown},
+            {AppState::OFF, Event::LONG_PRESS, nullptr, AppState::OFF, logForceShutdown},
+            {AppState::BOOTING, Event::LONG_PRESS, nullptr, AppState::OFF, logForceShutdown},
+            {AppState::CONNECTED, Event::LONG_PRESS, nullptr, AppState::OFF, logForceShutdown},
+            {AppState::SHUTTING_DOWN, Event::LONG_PRESS, nullptr, AppState::OFF, logForceShutdown},
+            {AppState::ERROR, Event::LONG_PRESS, nullptr, AppState::OFF, logForceShutdown}};
+
+        for (const Transition &row : TRANSITIONS)
+        {
+            Transition t;
+            memcpy_P(&t, &row, sizeof(t));
 
-            switch (g_state)
+            if (t.from == g_state && t.event == event && (!t.guard || t.guard()))
             {
-            case AppState::OFF:
-                handleOffState();
-                break;
-            case AppState::BOOTING:
-                handleBootState();
-                break;
-            case AppState::CONNECTED:
-                handleConnectedState();
-                break;
-            case AppState::SHUTTING_DOWN:
-                handleShutdownState();
-                break;
-            case AppState::ERROR:
-                handleErrorState();
-                break;
+                transition(t.to, t.action);
+                return true;
             }
+        }
 
-            g_pwrBtn.clearState();
+        return false;
+    }
+
+    bool dispatchInput()
+    {
+        if (g_pwrBtn.clicked() && dispatch(Event::CLICK))
+        {
+            // Entered state is timed from the click edge, not from the loop iteration that saw it
+            g_stateStamp = g_pwrBtn.eventStamp();
+            return true;
+        }
+
+        // Before OFF state run, it takes the move as activity
+        return g_gameSelector.preview() != g_activityPreview && dispatch(Event::SELECT);
+    }
 
-            // logHighwater();
+    void transition(AppState to, Action action)
+    {
+        unsigned long start = micros();
 
-            vTaskDelay(pdMS_TO_TICKS(20));
+        Action exit = hooks(g_state).exit;
+        if (exit)
+        {
+            exit();
+        }
+        if (action)
+        {
+            action();
+        }
+
+        unsigned long dwell = (millis() - g_stateStamp) / 1000;
+        g_stats.states[static_cast<uint8_t>(g_state)].lastDwell = dwell < UINT16_MAX ? dwell : UINT16_MAX;
+
+        enter(to);
+
+        unsigned long latency = micros() - start;
+        g_stats.lastLatency = latency < UINT16_MAX ? latency : UINT16_MAX;
+        if (g_stats.lastLatency > g_stats.maxLatency)
+        {
+            g_stats.maxLatency = g_stats.lastLatency;
         }
     }
 
-    void setAppState(AppState s)
+    void enter(AppState s)
     {
         g_state = s;
-        switch (s)
+        g_stateStamp = millis();
+        g_stats.states[static_cast<uint8_t>(s)].entries++;
+
+        Power::setSleepAllowed(false);
+        g_gameSelector.setBlank(false);
+        g_activityStamp = millis();
+        g_activityPreview = g_gameSelector.preview();
+
+        if (s != AppState::BOOTING && s != AppState::CONNECTED)
         {
-        case AppState::OFF:
-            g_sbc.off();
-            g_joy1.off();
-            g_joy2.off();
-            g_ledCtrl.setEffect(LightEffectors::Effect::OFF);
+            Boot::finish();
+        }
 
-            Disp::forceOff();
+        Action entry = hooks(s).enter;
+        if (entry)
+        {
+            entry();
+        }
+    }
 
-            Comm::clearShutdownFlag(); // Just in case that SBC manages
-                                       // to write this flag again on shutdown
-            State::setShutdownRequest(false);
-            Comm::disconnect();
+    StateHooks hooks(AppState s)
+    {
+        // Indexed by AppState
+        static constexpr StateHooks HOOKS[STATES] PROGMEM = {
+            {enterOff, nullptr, handleIdlePower},
+            {enterBooting, nullptr, runBooting},
+            {enterConnected, exitConnected, runConnected},
+            {enterShutdown, nullptr, runShutdown},
+            {enterError, nullptr, nullptr}};
+
+        StateHooks res;
+        memcpy_P(&res, &HOOKS[static_cast<uint8_t>(s)], sizeof(res));
+        return res;
+    }
 
-            break;
+    void enterOff()
+    {
+        Resume::setPowered(false);
 
-        case AppState::BOOTING:
-            g_sbc.on();
-            g_joy1.off();
-            g_joy2.off();
-            g_ledCtrl.setEffect(LightEffectors::Effect::BLINKING);
+        g_sbc.off();
+        g_ledCtrl.setEffect(LightEffectors::Effect::OFF);
 
-            g_bootStamp = millis();
+        Disp::forceOff();
 
-            break;
-        case AppState::CONNECTED:
-            g_ledCtrl.setEffect(LightEffectors::Effect::MANUAL);
+        releaseSbc(false); // Just in case that SBC manages to write shutdown flag again on shutdown
+    }
 
-            Disp::removeForceOff();
+    void enterBooting()
+    {
+        Resume::setPowered(true);
 
-            break;
+        g_sbc.on();
+        g_ledCtrl.setEffect(LightEffectors::Effect::BLINKING);
 
-        case AppState::SHUTTING_DOWN:
-            g_joy1.off();
-            g_joy2.off();
-            g_ledCtrl.setEffect(LightEffectors::Effect::ALTERNATING_BLINKING);
+        Comm::clearBootPhase();
+        Boot::start();
+    }
 
-            Disp::forceOff();
+    void enterConnected()
+    {
+        g_ledCtrl.setEffect(LightEffectors::Effect::MANUAL);
 
-            Comm::clearShutdownFlag();
-            State::setShutdownRequest(true);
-            Comm::disconnect();
+        Disp::removeForceOff();
+    }
 
-            g_bootStamp = millis();
+    void exitConnected()
+    {
+        // Joys are powered only while connected, init leaves them off in other states
+        g_joy1.off();
+        g_joy2.off();
+    }
 
-            break;
+    void enterShutdown()
+    {
+        Resume::setPowered(false);
 
-        case AppState::ERROR:
-            g_ledCtrl.setEffect(LightEffectors::Effect::FAST_BLINKING);
-            Disp::removeForceOff();
-            State::setDisplayState(true); // Force ON to see error cause
+        g_ledCtrl.setEffect(LightEffectors::Effect::ALTERNATING_BLINKING);
 
-            Comm::clearShutdownFlag();
-            State::setShutdownRequest(false);
-            Comm::disconnect();
+        Disp::forceOff();
 
-            g_joy1.off();
-            g_joy2.off();
+        releaseSbc(true);
 
-            break;
-        }
+        g_haltDetected = false;
     }
 
-    void handleForceShutdown()
+    void enterError()
     {
-        setAppState(AppState::OFF);
+        g_ledCtrl.setEffect(LightEffectors::Effect::FAST_BLINKING);
+        Disp::removeForceOff();
+        State::setDisplayState(true); // Force ON to see error cause
 
-        LOG_INFO(F("Force sdown"));
+        releaseSbc(false);
     }
 
-    void handleOffState()
+    void releaseSbc(bool shutdownRequest)
     {
-        if (g_pwrBtn.clicked())
-        {
-            setAppState(AppState::BOOTING);
+        Comm::clearShutdownFlag();
+        State::setShutdownRequest(shutdownRequest);
+        Comm::disconnect();
+    }
 
-            LOG_INFO(F("Booting"));
-        }
+    void runBooting()
+    {
+        Boot::report(State::getBootPhase());
     }
 
-    void handleBootState()
+    void runConnected()
     {
-        if (Comm::connected())
+        Boot::report(State::getBootPhase());
+
+        // SBC stays usable over daemon, hung frontend is only flagged until next scene
+        if (Boot::frontendTimedOut())
         {
-            setAppState(AppState::CONNECTED);
+            Boot::fail();
+            g_ledCtrl.setEffect(LightEffectors::Effect::FAST_BLINKING);
 
-            LOG_INFO(F("Boot ok"));
+            LOG_ERROR(F("Frontend tout"));
         }
 
-        if (millis() - g_bootStamp >= Config::AppTask::BOOT_TIMEOUT_DURATION)
-        {
-            setAppState(AppState::ERROR);
-            LOG_ERROR(F("Boot tout"));
-        }
-    }
+        handleProfile();
+        handleScene();
 
-    void handleConnectedState()
-    {
         if (State::getJoy1Enable())
         {
             g_joy1.on();
@@ -263,54 +655,196 @@ namespace App
         {
             g_joy2.off();
         }
+    }
 
-        if (!Comm::connected())
+    void runShutdown()
+    {
+        // Halt pin alone could be a glitch or SBC still booting, daemon must be gone as well
+        if (!g_haltDetected && g_sbc.halted() && Comm::heartbeatSilence() >= Config::SBC::HALT_HB_SILENCE)
         {
-            setAppState(AppState::ERROR);
+            g_haltDetected = true;
+            g_haltStamp = millis();
 
-            LOG_ERROR(F("Disconn"));
+            LOG_INFO(F("SBC halted"));
         }
-        if (State::getShutdownFlag())
-        {
-            setAppState(AppState::SHUTTING_DOWN);
+    }
 
-            LOG_INFO(F("SBC sdown"));
-        }
-        if (g_pwrBtn.clicked())
+    void handleIdlePower()
+    {
+        // Wakes by display detection or UART aren't user activity
+        if (g_pwrBtn.pressed() || g_gameSelector.preview() != g_activityPreview)
         {
-            setAppState(AppState::SHUTTING_DOWN);
-
-            LOG_INFO(F("Btn sdown"));
+            g_activityPreview = g_gameSelector.preview();
+            g_activityStamp = millis();
         }
+
+        bool idle = millis() - g_activityStamp >= Config::Power::IDLE_DELAY;
+        g_gameSelector.setBlank(idle);
+        Power::setSleepAllowed(idle && g_gameSelector.displayIdle());
+    }
+
+    bool disconnected()
+    {
+        return !Comm::connected();
+    }
+
+    bool haltConfirmed()
+    {
+        return g_haltDetected && millis() - g_haltStamp >= Config::SBC::HALT_GUARD;
+    }
+
+    bool shutdownElapsed()
+    {
+        return millis() - g_stateStamp >= Settings::shutdownDuration();
+    }
+
+    void logBooting()
+    {
+        LOG_INFO(F("Booting"));
+    }
+
+    void logSelectWake()
+    {
+        // Player keeps choosing while SBC boots, applied slot is loaded once it's up
+        LOG_INFO(F("Sel wake"));
+    }
+
+    void bootSucceeded()
+    {
+        Boot::report(static_cast<uint8_t>(Boot::Phase::DAEMON));
+
+        LOG_INFO(F("Boot ok"));
+    }
+
+    void bootFailed()
+    {
+        Boot::fail();
+
+        LOG_ERROR(F("Boot tout"));
+    }
+
+    void logButtonShutdown()
+    {
+        LOG_INFO(F("Btn sdown"));
+    }
+
+    void logSbcShutdown()
+    {
+        LOG_INFO(F("SBC sdown"));
     }
 
-    void handleShutdownState()
+    void logDisconnected()
     {
-        if (millis() - g_bootStamp >= Config::AppTask::SHUTDOWN_DURATION)
+        LOG_ERROR(F("Disconn"));
+    }
+
+    void haltedShutdown()
+    {
+        Boot::shutdown(g_haltStamp - g_stateStamp, true);
+
+        LOG_INFO(F("sdown ok"));
+    }
+
+    void timedShutdown()
+    {
+        Boot::shutdown(millis() - g_stateStamp, false);
+
+        LOG_INFO(F("sdown ok"));
+    }
+
+    void logForceShutdown()
+    {
+        LOG_INFO(F("Force sdown"));
+    }
+
+    void handleProfile()
+    {
+        uint16_t slot = State::getSelectorValue();
+        if (slot == g_appliedSlot)
         {
-            setAppState(AppState::OFF);
+            return;
+        }
+        g_appliedSlot = slot;
 
-            LOG_INFO(F("sdown ok"));
+        Profiles::Profile profile;
+        if (!Profiles::get(slot, profile))
+        {
+            return;
         }
+
+        Comm::setJoys(profile.joy1Enable, profile.joy2Enable, profile.joy1Brightness, profile.joy2Brightness);
+        g_ledCtrl.setManualBrightness(profile.joy1Brightness, profile.joy2Brightness);
+        setLedEffect(profile.effect);
     }
 
-    void handleErrorState()
+    void handleScene()
     {
-        if (g_pwrBtn.clicked())
+        if (g_sceneStepPending)
+        {
+            if (millis() - g_sceneStepStamp < g_scene.stepDelay)
+            {
+                return;
+            }
+
+            if (g_scene.displayLast)
+            {
+                applySceneDisplay();
+            }
+            else
+            {
+                applySceneJoys();
+            }
+            g_sceneStepPending = false;
+            Comm::setSceneDone(g_scene.seq);
+        }
+
+        // New scene replaces pending one, its first step is applied right away
+        if (!State::takeScene(g_scene))
         {
-            setAppState(AppState::OFF);
+            return;
+        }
 
-            LOG_INFO(F("Btn sdown"));
+        if (g_scene.displayLast)
+        {
+            applySceneJoys();
+        }
+        else
+        {
+            applySceneDisplay();
+        }
+
+        g_sceneStepPending = true;
+        g_sceneStepStamp = millis();
+
+        if (g_scene.stepDelay == 0)
+        {
+            handleScene();
         }
     }
 
-#ifdef GAME_SELECTOR_ENCODER
-    void selectorClkISRhandler()
+    void applySceneDisplay()
     {
-        g_gameSelector.encoderUpdate();
+        Comm::setDisplayState(g_scene.display);
     }
 
-#endif
+    void applySceneJoys()
+    {
+        Comm::setJoys(g_scene.joy1Enable, g_scene.joy2Enable, g_scene.joy1Brightness, g_scene.joy2Brightness);
+        g_ledCtrl.setManualBrightness(g_scene.joy1Brightness, g_scene.joy2Brightness);
+        setLedEffect(g_scene.effect);
+    }
+
+    void setLedEffect(uint8_t code)
+    {
+        if (code == 0)
+        {
+            g_ledCtrl.setEffect(LightEffectors::Effect::MANUAL);
+        }
+        else if (code - 1 < LightEffectors::EFFECTS)
+        {
+            g_ledCtrl.setEffect(static_cast<LightEffectors::Effect>(code - 1));
+        }
+    }
 
     void logHighwater()
     {
@@ -319,9 +853,35 @@ namespace App
 
         if (millis() - stamp >= period)
         {
+#ifndef COOP_EXECUTOR
             uint16_t uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
             LOG_INFO(String(F("app: ")) + String(uxHighWaterMark));
+#endif
             stamp = millis();
         }
     }
 }
+
+ISR(PCINT0_vect)
+{
+    g_gameSelector.applyBtnEdge();
+}
+
+#ifdef GAME_SELECTOR_ENCODER
+ISR(PCINT1_vect)
+{
+    g_gameSelector.encoderUpdate();
+}
+
+ISR(DISPLAY_TIMER_vect)
+{
+    g_gameSelector.displayStep();
+}
+#endif
+
+ISR(PCINT2_vect)
+{
+    // Shared by power button and display detection, both ignore changes of the other pin
+    g_pwrBtn.onEdge();
+    Disp::detEdge();
+}
\ No newline at end of file
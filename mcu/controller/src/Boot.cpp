@@ -0,0 +1,241 @@
+#include "Boot.hpp"
+#include <EEPROM.h>
+#include <util/crc16.h>
+#include "Settings.hpp"
+#include "Config.hpp"
+
+namespace
+{
+    constexpr uint8_t TIMED_PHASES = Boot::PHASES - 1; // POWERED is time zero.
+    constexpr unsigned long UNIT = 100;                // ms per stored time unit.
+
+    struct Record
+    {
+        uint16_t at[TIMED_PHASES]; // 0 if phase wasn't reported.
+    };
+
+    struct History
+    {
+        uint8_t head; // Next record to overwrite.
+        uint8_t count;
+        Record records[Config::Boot::HISTORY];
+        uint16_t crc;
+    };
+
+    static_assert(Config::Boot::EEPROM_ADDR + sizeof(History) <= Config::Resume::EEPROM_ADDR, "Boot history overlaps resume state");
+
+    bool g_running = false; // Boot in progress and not recorded yet.
+    unsigned long g_startStamp = 0;
+    Boot::Stats g_stats;
+}
+
+namespace Boot
+{
+    void init();
+    void start();
+    void report(uint8_t phase);
+    bool timedOut();
+    bool frontendTimedOut();
+    void fail();
+    void finish();
+    void shutdown(unsigned long duration, bool halted);
+    Stats stats();
+
+    /**
+     * @brief Append current boot to history.
+     */
+    void record();
+
+    /**
+     * @brief Derive phase deadlines from history.
+     */
+    void learn(const History &history);
+    bool load(History &history);
+    void save(History &history);
+    uint16_t crc(const History &history);
+
+    void init()
+    {
+        History history;
+        if (!load(history))
+        {
+            history.count = 0;
+        }
+
+        learn(history);
+    }
+
+    void start()
+    {
+        g_running = true;
+        g_startStamp = millis();
+        g_stats.phase = static_cast<uint8_t>(Phase::POWERED);
+
+        for (uint8_t i = 0; i < TIMED_PHASES; i++)
+        {
+            g_stats.last[i] = 0;
+        }
+    }
+
+    void report(uint8_t phase)
+    {
+        if (!g_running || phase <= g_stats.phase || phase >= PHASES)
+        {
+            return;
+        }
+
+        unsigned long at = (millis() - g_startStamp) / UNIT;
+        g_stats.last[phase - 1] = at > 0xFFFF ? 0xFFFF : (at ? at : 1);
+        g_stats.phase = phase;
+
+        if (phase == static_cast<uint8_t>(Phase::FRONTEND))
+        {
+            record();
+        }
+    }
+
+    bool timedOut()
+    {
+        unsigned long elapsed = millis() - g_startStamp;
+        unsigned long limit = Settings::bootTimeout();
+
+        // First awaited phase with history sets the deadline, SBC may not report all of them
+        for (uint8_t phase = g_stats.phase + 1; phase < PHASES; phase++)
+        {
+            if (g_stats.deadline[phase - 1])
+            {
+                limit = min(limit, g_stats.deadline[phase - 1] * UNIT);
+                break;
+            }
+        }
+
+        return elapsed >= limit;
+    }
+
+    bool frontendTimedOut()
+    {
+        uint16_t deadline = g_stats.deadline[static_cast<uint8_t>(Phase::FRONTEND) - 1];
+        if (!g_running || g_stats.phase != static_cast<uint8_t>(Phase::DAEMON) || !deadline)
+        {
+            return false;
+        }
+
+        return millis() - g_startStamp >= deadline * UNIT;
+    }
+
+    void fail()
+    {
+        if (g_stats.phase >= static_cast<uint8_t>(Phase::DAEMON))
+        {
+            g_stats.lateFrontends++;
+        }
+        g_running = false;
+        g_stats.timeouts++;
+
+        History history;
+        history.head = 0;
+        history.count = 0;
+        save(history);
+        learn(history);
+    }
+
+    void finish()
+    {
+        if (g_running && g_stats.phase >= static_cast<uint8_t>(Phase::DAEMON))
+        {
+            record();
+        }
+
+        g_running = false;
+    }
+
+    void shutdown(unsigned long duration, bool halted)
+    {
+        duration /= UNIT;
+        g_stats.shutdown = duration > 0xFFFF ? 0xFFFF : duration;
+
+        if (halted)
+        {
+            g_stats.earlyCuts++;
+        }
+        else
+        {
+            g_stats.lateCuts++;
+        }
+    }
+
+    Stats stats()
+    {
+        return g_stats;
+    }
+
+    void record()
+    {
+        g_running = false;
+
+        History history;
+        if (!load(history))
+        {
+            history.head = 0;
+            history.count = 0;
+        }
+
+        for (uint8_t i = 0; i < TIMED_PHASES; i++)
+        {
+            history.records[history.head].at[i] = g_stats.last[i];
+        }
+        history.head = (history.head + 1) % Config::Boot::HISTORY;
+        if (history.count < Config::Boot::HISTORY)
+        {
+            history.count++;
+        }
+
+        save(history);
+        learn(history);
+    }
+
+    void learn(const History &history)
+    {
+        g_stats.records = history.count;
+
+        for (uint8_t i = 0; i < TIMED_PHASES; i++)
+        {
+            uint16_t slowest = 0;
+            for (uint8_t j = 0; j < history.count; j++)
+            {
+                slowest = max(slowest, history.records[j].at[i]);
+            }
+
+            unsigned long deadline = slowest
+                                         ? slowest * (unsigned long)Config::Boot::TIMEOUT_MARGIN_PERCENT / 100 + Config::Boot::TIMEOUT_SLACK / UNIT
+                                         : 0;
+            g_stats.deadline[i] = deadline > 0xFFFF ? 0xFFFF : deadline;
+        }
+    }
+
+    bool load(History &history)
+    {
+        EEPROM.get(Config::Boot::EEPROM_ADDR, history);
+
+        return history.crc == crc(history) && history.head < Config::Boot::HISTORY && history.count <= Config::Boot::HISTORY;
+    }
+
+    void save(History &history)
+    {
+        history.crc = crc(history);
+        EEPROM.put(Config::Boot::EEPROM_ADDR, history);
+    }
+
+    uint16_t crc(const History &history)
+    {
+        uint16_t res = 0xFFFF; // Erased EEPROM (all 0xFF) doesn't pass the check.
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&history);
+
+        for (uint8_t i = 0; i < offsetof(History, crc); i++)
+        {
+            res = _crc16_update(res, bytes[i]);
+        }
+
+        return res;
+    }
+}
\ No newline at end of file
@@ -1,59 +1,131 @@
 #include "Button.hpp"
+#include "Settings.hpp"
 #include "Config.hpp"
 
-Button::Button(uint8_t pin, bool activeLow) : m_pin(pin)
+void Button::init(bool pressed)
 {
-    if (activeLow)
-    {
-        RELEASED = true;
-        PRESSED = false;
-    }
+    m_stablePressed = pressed;
+    m_lastEdgePressed = pressed;
+    m_heldAtInit = pressed;
+
+    m_pressedStartStamp = millis();
 }
 
-void Button::init()
+void Button::onEdge(bool pressed)
 {
-    pinMode(m_pin, INPUT);
+    if (pressed == m_lastEdgePressed)
+    {
+        return;
+    }
+    m_lastEdgePressed = pressed;
+
+    uint8_t next = (m_queueHead + 1) % QUEUE_SIZE;
+
+    if (next == m_queueTail)
+    {
+        m_queueOverflow = true;
+        return;
+    }
+
+    m_queue[m_queueHead].stamp = millis();
+    m_queue[m_queueHead].pressed = pressed;
+    m_queueHead = next;
 }
 
-void Button::update()
+bool Button::popEdge(Edge &edge)
 {
-    if(m_fstScan)
+    bool res = false;
+
+    noInterrupts();
+    if (m_queueTail != m_queueHead)
     {
-        m_fstScan = false;
-        m_previousState = digitalRead(m_pin);;
-        return;
+        edge.stamp = m_queue[m_queueTail].stamp;
+        edge.pressed = m_queue[m_queueTail].pressed;
+        m_queueTail = (m_queueTail + 1) % QUEUE_SIZE;
+        res = true;
     }
+    interrupts();
+
+    return res;
+}
 
-    bool state = digitalRead(m_pin);
+void Button::update(bool pressed)
+{
+    unsigned long now = millis();
 
-    if (state != m_previousState)
+    Edge edge;
+    while (popEdge(edge))
     {
-        if (state == PRESSED)
+        // Expand 16 bit stamp relative to now
+        unsigned long stamp = now - (uint16_t)((uint16_t)now - edge.stamp);
+
+        if (m_pending && stamp - m_pendingLastStamp >= Config::PwrButton::DEBOUNCE_TIME)
         {
-            m_pressedStartStamp = millis();
+            onStableChange(m_pendingPressed, m_pendingStartStamp);
+            m_pending = false;
         }
-        else
+
+        if (!m_pending)
         {
-            if (millis() - m_pressedStartStamp <= Config::PwrButton::CLICK_TIMEOUT)
-            {
-                m_clicked = true;
-            }
+            m_pending = true;
+            m_pendingStartStamp = stamp;
         }
-        m_previousState = state;
+        m_pendingPressed = edge.pressed;
+        m_pendingLastStamp = stamp;
     }
-    else if (state == PRESSED)
+
+    if (m_pending && now - m_pendingLastStamp >= Config::PwrButton::DEBOUNCE_TIME)
     {
-        if (millis() - m_pressedStartStamp >= Config::PwrButton::LONG_PRESS_MIN_TIME)
-        {
-            m_longPressed = true;
-        }
+        onStableChange(m_pendingPressed, m_pendingStartStamp);
+        m_pending = false;
+    }
+
+    // Edges were lost, trust the pin itself
+    if (m_queueOverflow)
+    {
+        m_queueOverflow = false;
+        m_pending = false;
+        onStableChange(pressed, now);
+    }
+
+    if (m_stablePressed && !m_heldAtInit && now - m_pressedStartStamp >= Config::PwrButton::LONG_PRESS_MIN_TIME)
+    {
+        m_longPressed = true;
     }
 }
 
+void Button::onStableChange(bool pressed, unsigned long stamp)
+{
+    if (pressed == m_stablePressed)
+    {
+        return;
+    }
+    m_stablePressed = pressed;
+
+    if (pressed)
+    {
+        m_pressedStartStamp = stamp;
+        return;
+    }
+
+    if (m_heldAtInit)
+    {
+        m_heldAtInit = false;
+        return;
+    }
+
+    if (stamp - m_pressedStartStamp > Settings::clickTimeout())
+    {
+        return;
+    }
+
+    m_clicked = true;
+    m_eventStamp = stamp;
+}
+
 bool Button::pressed()
 {
-    bool state = digitalRead(m_pin);
-    return state == PRESSED;
+    return m_stablePressed;
 }
 
 bool Button::longPressed()
@@ -66,6 +138,11 @@ bool Button::clicked()
     return m_clicked;
 }
 
+unsigned long Button::eventStamp()
+{
+    return m_eventStamp;
+}
+
 void Button::clearState()
 {
     m_clicked = false;
@@ -0,0 +1,75 @@
+#include "Cadence.hpp"
+#include "Config.hpp"
+
+namespace
+{
+    unsigned long g_activityStamp = 0;
+    unsigned long g_updateStamp = 0;
+    Cadence::Mode g_mode = Cadence::Mode::NORMAL;
+    uint16_t g_period = Config::AppTask::LOOP_PERIOD;
+
+    unsigned long g_modeMs[Cadence::MODES] = {0, 0, 0, 0};
+}
+
+namespace Cadence
+{
+    void activity();
+    uint16_t update(bool animating);
+    uint16_t period();
+    Stats stats();
+
+    void activity()
+    {
+        g_activityStamp = millis();
+    }
+
+    uint16_t update(bool animating)
+    {
+        // Time since last update was spent in mode chosen by it
+        unsigned long now = millis();
+        g_modeMs[static_cast<uint8_t>(g_mode)] += now - g_updateStamp;
+        g_updateStamp = now;
+
+        unsigned long quiet = now - g_activityStamp;
+        if (quiet < Config::AppTask::ACTIVITY_HOLD)
+        {
+            g_mode = Mode::FAST;
+            g_period = Config::AppTask::FAST_LOOP_PERIOD;
+        }
+        else if (animating)
+        {
+            g_mode = Mode::ANIMATION;
+            g_period = Config::AppTask::ANIMATION_LOOP_PERIOD;
+        }
+        else if (quiet < Config::AppTask::STABLE_DELAY)
+        {
+            g_mode = Mode::NORMAL;
+            g_period = Config::AppTask::LOOP_PERIOD;
+        }
+        else
+        {
+            g_mode = Mode::IDLE;
+            g_period = Config::AppTask::IDLE_LOOP_PERIOD;
+        }
+
+        return g_period;
+    }
+
+    uint16_t period()
+    {
+        return g_period;
+    }
+
+    Stats stats()
+    {
+        Stats res;
+        res.period = g_period;
+        res.mode = static_cast<uint8_t>(g_mode);
+        for (uint8_t i = 0; i < MODES; i++)
+        {
+            res.seconds[i] = min(g_modeMs[i] / 1000, 0xFFFFUL);
+        }
+
+        return res;
+    }
+}
\ No newline at end of file
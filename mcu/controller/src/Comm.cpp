@@ -1,8 +1,12 @@
 #include "Comm.hpp"
-#include <Arduino_FreeRTOS.h>
 #include <MSlave.h>
 #include "Log.hpp"
 #include "State.hpp"
+#include "Diag.hpp"
+#include "Trace.hpp"
+#include "Profiles.hpp"
+#include "Settings.hpp"
+#include "Cadence.hpp"
 
 #include "Config.hpp"
 
@@ -10,12 +14,46 @@ namespace
 {
     bool g_connected = false;
     uint8_t g_sbcHeartbeatRetries = 0;
+    unsigned long g_sbcHeartbeatStamp = 0; // Last change of SBC heartbeat counter.
 
     MSlave<Config::Communication::Coils::Q_JOY2_ENA_FLAG_ADDR + 1,
            Config::Communication::Inputs::I_SHUTDOWN_REQ_ADDR + 1,
-           Config::Communication::HoldingRegs::AQ_JOY2_LED_BRIGHTNESS_ADDR + 1,
-           Config::Communication::InputRegs::AI_MCU_GAMESEL_ADDR + 1>
+           Config::Communication::HoldingRegs::AQ_STREAM_FRAME_ADDR +
+               Config::Communication::HoldingRegs::STREAM_FRAMES * Config::Communication::HoldingRegs::STREAM_FRAME_SIZE,
+           Config::Communication::InputRegs::AI_STREAM_LATE_ADDR + 1>
         g_server;
+
+    enum class Kind : uint8_t
+    {
+        COIL,
+        DISCRETE_INPUT,
+        HOLDING,
+        INPUT_REGISTER
+    };
+
+    /**
+     * @brief Server register of State::Field.
+     */
+    struct Register
+    {
+        Kind kind;
+        uint8_t addr;
+    };
+
+    // Indexed by State::Field
+    constexpr Register REGISTERS[State::FIELDS] PROGMEM = {
+        {Kind::COIL, Config::Communication::Coils::Q_SHUTDOWN_FLAG_ADDR},
+        {Kind::COIL, Config::Communication::Coils::Q_DISPLAY_STATE_ADDR},
+        {Kind::COIL, Config::Communication::Coils::Q_JOY1_ENA_FLAG_ADDR},
+        {Kind::COIL, Config::Communication::Coils::Q_JOY2_ENA_FLAG_ADDR},
+        {Kind::HOLDING, Config::Communication::HoldingRegs::AQ_JOY1_LED_BRIGHTNESS_ADDR},
+        {Kind::HOLDING, Config::Communication::HoldingRegs::AQ_JOY2_LED_BRIGHTNESS_ADDR},
+        {Kind::HOLDING, Config::Communication::HoldingRegs::AQ_GAMESEL_MAX_ADDR},
+        {Kind::HOLDING, Config::Communication::HoldingRegs::AQ_BOOT_PHASE_ADDR},
+        {Kind::DISCRETE_INPUT, Config::Communication::Inputs::I_SHUTDOWN_REQ_ADDR},
+        {Kind::INPUT_REGISTER, Config::Communication::InputRegs::AI_MCU_GAMESEL_ADDR},
+        {Kind::INPUT_REGISTER, Config::Communication::InputRegs::AI_GAMESEL_PREVIEW_ADDR},
+        {Kind::INPUT_REGISTER, Config::Communication::InputRegs::AI_GAMESEL_DWELL_ADDR}};
 }
 
 namespace Comm
@@ -23,14 +61,61 @@ namespace Comm
     void init();
     void update();
     bool connected();
+    unsigned long heartbeatSilence();
     void disconnect();
+    void assumeConnected();
     void clearShutdownFlag();
+    void clearBootPhase();
+    void setDisplayState(bool state);
+    void setJoys(bool joy1Enable, bool joy2Enable, uint8_t joy1Brightness, uint8_t joy2Brightness);
+    void setSceneDone(uint16_t seq);
 
     /**
-     * @brief Update State.hpp variables with data from MODBUS server.
+     * @brief Pass new scene from MODBUS registers to State.
+     */
+    void updateScene();
+
+    /**
+     * @brief Pass newest LED frame from stream buffers to State, count dropped and late frames.
+     */
+    void updateStream();
+
+    /**
+     * @brief How many frames seq is ahead of prev, values from 0x8000 up mean it's behind.
+     */
+    uint16_t seqDistance(uint16_t seq, uint16_t prev);
+    bool seqAhead(uint16_t seq, uint16_t prev);
+
+    /**
+     * @brief Store profile block uploaded by SBC to EEPROM.
+     */
+    void updateProfiles();
+
+    /**
+     * @brief Store settings written by SBC to EEPROM.
+     */
+    void updateSettings();
+
+    /**
+     * @brief Expose active settings in their holding registers so SBC can read them back.
+     */
+    void writeSettings();
+
+    /**
+     * @brief Exchange State register image with MODBUS server.
      */
     void updateState();
 
+    /**
+     * @brief Push fields written by MCU to server, pull the ones SBC writes. Called by State::sync().
+     */
+    void syncRegisters(State::Image &image);
+
+    /**
+     * @brief Take field value written by SBC into image, a change counts as activity.
+     */
+    void pull(State::Image &image, uint8_t field, uint16_t value);
+
     /**
      * @brief Check SBC heartbeat status.
      */
@@ -41,25 +126,43 @@ namespace Comm
      */
     void doMcuHeartbeat();
 
+    /**
+     * @brief Expose diag page requested by SBC.
+     */
+    void updateDiag();
+
+    /**
+     * @brief Store single diag value in diag window.
+     */
+    void writeDiag(uint8_t idx, uint16_t val);
+
     void init()
     {
-        Serial.begin(Config::Communication::SERIAL_BAUD);
+        Serial.begin(Settings::serialBaud());
         Serial.setTimeout(Config::Communication::SERIAL_TIMEOUT);
         g_server.begin(Config::Communication::DEVICE_ID, Serial);
 
+        writeSettings();
+
         LOG_INFO(F("Comm start"));
     }
 
     void update()
     {
+        // Routine polls and heartbeats aren't activity, only requests that change state are
         if (g_server.available())
         {
             g_server.read();
         }
 
         updateState();
+        updateScene();
+        updateStream();
+        updateProfiles();
+        updateSettings();
         sbcHeartbeatCheck();
         doMcuHeartbeat();
+        updateDiag();
     }
 
     bool connected()
@@ -67,6 +170,11 @@ namespace Comm
         return g_connected;
     }
 
+    unsigned long heartbeatSilence()
+    {
+        return millis() - g_sbcHeartbeatStamp;
+    }
+
     void disconnect()
     {
         g_connected = false;
@@ -74,25 +182,291 @@ namespace Comm
 
     }
 
+    void assumeConnected()
+    {
+        g_connected = true;
+        g_sbcHeartbeatRetries = 0;
+        g_sbcHeartbeatStamp = millis();
+    }
+
+    // Setters below mark State fields dirty, they reach server on next sync
+
     void clearShutdownFlag()
     {
-        g_server.digitalWrite(COIL, Config::Communication::Coils::Q_SHUTDOWN_FLAG_ADDR, false);
         State::setShutdownFlag(false);
     }
 
+    void clearBootPhase()
+    {
+        State::setBootPhase(0);
+    }
+
+    void setDisplayState(bool state)
+    {
+        State::setDisplayState(state);
+    }
+
+    void setJoys(bool joy1Enable, bool joy2Enable, uint8_t joy1Brightness, uint8_t joy2Brightness)
+    {
+        State::setJoy1Enable(joy1Enable);
+        State::setJoy2Enable(joy2Enable);
+        State::setJoy1Brightness(joy1Brightness);
+        State::setJoy2Brightness(joy2Brightness);
+    }
+
+    void setSceneDone(uint16_t seq)
+    {
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_SCENE_DONE_SEQ_ADDR, seq);
+    }
+
+    void updateScene()
+    {
+        static uint16_t prevSeq = 0;
+
+        uint16_t seq = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SCENE_SEQ_ADDR);
+        if (seq == prevSeq)
+        {
+            return;
+        }
+        prevSeq = seq;
+        Cadence::activity();
+
+        uint16_t flags = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SCENE_FLAGS_ADDR);
+        uint16_t brightness = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SCENE_BRIGHTNESS_ADDR);
+
+        State::Scene scene;
+        scene.seq = seq;
+        scene.display = flags & (1 << 0);
+        scene.joy1Enable = flags & (1 << 1);
+        scene.joy2Enable = flags & (1 << 2);
+        scene.displayLast = flags & (1 << 3);
+        scene.effect = (flags >> 8) & 0x0F;
+        scene.joy1Brightness = brightness & 0xFF;
+        scene.joy2Brightness = brightness >> 8;
+        scene.stepDelay = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SCENE_DELAY_ADDR);
+
+        State::setScene(scene);
+    }
+
+    void updateStream()
+    {
+        static uint16_t prevSeqs[Config::Communication::HoldingRegs::STREAM_FRAMES] = {0, 0};
+        static uint16_t lastSeq = 0;
+        static unsigned long lastStamp = 0;
+        static uint16_t dropped = 0;
+        static uint16_t late = 0;
+
+        unsigned long gap = millis() - lastStamp;
+        bool restart = lastSeq == 0 || gap >= Config::LightEffector::STREAM_RESTART_GAP;
+
+        // Newest buffer written since last check, both are written if MCU fell behind
+        uint8_t newest = Config::Communication::HoldingRegs::STREAM_FRAMES;
+        for (uint8_t i = 0; i < Config::Communication::HoldingRegs::STREAM_FRAMES; i++)
+        {
+            uint8_t addr = Config::Communication::HoldingRegs::AQ_STREAM_FRAME_ADDR +
+                           i * Config::Communication::HoldingRegs::STREAM_FRAME_SIZE;
+            uint16_t seq = g_server.analogRead(HOLDING_REG, addr + 1);
+            if (seq == prevSeqs[i])
+            {
+                continue;
+            }
+            prevSeqs[i] = seq;
+
+            // Running stream only moves forward, new one (e.g. restarted daemon) may start anywhere
+            if ((restart || seqAhead(seq, lastSeq)) &&
+                (newest == Config::Communication::HoldingRegs::STREAM_FRAMES || seqAhead(seq, prevSeqs[newest])))
+            {
+                newest = i;
+            }
+        }
+
+        if (newest == Config::Communication::HoldingRegs::STREAM_FRAMES)
+        {
+            return;
+        }
+
+        uint8_t addr = Config::Communication::HoldingRegs::AQ_STREAM_FRAME_ADDR +
+                       newest * Config::Communication::HoldingRegs::STREAM_FRAME_SIZE;
+        uint16_t brightness = g_server.analogRead(HOLDING_REG, addr);
+
+        State::Frame frame;
+        frame.seq = prevSeqs[newest];
+        frame.joy1Brightness = brightness & 0xFF;
+        frame.joy2Brightness = brightness >> 8;
+        State::setFrame(frame);
+        Cadence::activity();
+
+        if (!restart)
+        {
+            uint16_t advance = seqDistance(frame.seq, lastSeq);
+            uint16_t interval = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_STREAM_INTERVAL_ADDR);
+
+            dropped += advance - 1;
+            if (interval && gap > (unsigned long)advance * interval + Config::LightEffector::STREAM_LATE_SLACK)
+            {
+                late++;
+            }
+        }
+        lastSeq = frame.seq;
+        lastStamp = millis();
+
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_STREAM_SEQ_ADDR, lastSeq);
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_STREAM_DROPPED_ADDR, dropped);
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_STREAM_LATE_ADDR, late);
+    }
+
+    uint16_t seqDistance(uint16_t seq, uint16_t prev)
+    {
+        // Zero is never sent, sequence wraps from 0xFFFF to 1
+        return seq - prev - (seq < prev ? 1 : 0);
+    }
+
+    bool seqAhead(uint16_t seq, uint16_t prev)
+    {
+        uint16_t distance = seqDistance(seq, prev);
+        return distance != 0 && distance < 0x8000;
+    }
+
+    void updateProfiles()
+    {
+        static uint16_t prevSeq = 0;
+
+        uint16_t seq = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_PROFILE_SEQ_ADDR);
+        if (seq == prevSeq)
+        {
+            return;
+        }
+        prevSeq = seq;
+        Cadence::activity();
+
+        uint16_t firstSlot = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_PROFILE_FIRST_SLOT_ADDR);
+        uint16_t count = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_PROFILE_COUNT_ADDR);
+        if (count > Config::Communication::HoldingRegs::PROFILE_BLOCK_SIZE)
+        {
+            count = Config::Communication::HoldingRegs::PROFILE_BLOCK_SIZE;
+        }
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            uint8_t addr = Config::Communication::HoldingRegs::AQ_PROFILE_DATA_ADDR + 2 * i;
+            uint16_t flags = g_server.analogRead(HOLDING_REG, addr);
+            uint16_t brightness = g_server.analogRead(HOLDING_REG, addr + 1);
+
+            if (flags & (1 << 15))
+            {
+                Profiles::erase(firstSlot + i);
+                continue;
+            }
+
+            Profiles::Profile profile;
+            profile.joy1Enable = flags & (1 << 1);
+            profile.joy2Enable = flags & (1 << 2);
+            profile.effect = (flags >> 8) & 0x0F;
+            profile.joy1Brightness = brightness & 0xFF;
+            profile.joy2Brightness = brightness >> 8;
+
+            Profiles::store(firstSlot + i, profile);
+        }
+
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_PROFILE_DONE_SEQ_ADDR, seq);
+        LOG_INFO(F("Profiles stored"));
+    }
+
+    void updateSettings()
+    {
+        static uint16_t prevSeq = 0;
+
+        uint16_t seq = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SETTINGS_SEQ_ADDR);
+        if (seq == prevSeq)
+        {
+            return;
+        }
+        prevSeq = seq;
+        Cadence::activity();
+
+        uint16_t values[Settings::COUNT];
+        for (uint8_t i = 0; i < Settings::COUNT; i++)
+        {
+            values[i] = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SETTINGS_DATA_ADDR + i);
+        }
+
+        Settings::store(values);
+
+        // Rejected values were replaced by defaults, let SBC see what is active
+        writeSettings();
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_SETTINGS_DONE_SEQ_ADDR, seq);
+        LOG_INFO(F("Settings stored"));
+    }
+
+    void writeSettings()
+    {
+        for (uint8_t i = 0; i < Settings::COUNT; i++)
+        {
+            g_server.analogWrite(HOLDING_REG, Config::Communication::HoldingRegs::AQ_SETTINGS_DATA_ADDR + i,
+                                 Settings::get(static_cast<Settings::Field>(i)));
+        }
+
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_SETTINGS_STORED_ADDR, Settings::stored());
+    }
+
     void updateState()
     {
-        State::setShutdownFlag(g_server.digitalRead(COIL, Config::Communication::Coils::Q_SHUTDOWN_FLAG_ADDR));
-        State::setDisplayState(g_server.digitalRead(COIL, Config::Communication::Coils::Q_DISPLAY_STATE_ADDR));
-        State::setJoy1Enable(g_server.digitalRead(COIL, Config::Communication::Coils::Q_JOY1_ENA_FLAG_ADDR));
-        State::setJoy2Enable(g_server.digitalRead(COIL, Config::Communication::Coils::Q_JOY2_ENA_FLAG_ADDR));
+        State::sync(syncRegisters);
+    }
 
-        g_server.digitalWrite(INPUT, Config::Communication::Inputs::I_SHUTDOWN_REQ_ADDR, State::getShutdownRequest());
+    void syncRegisters(State::Image &image)
+    {
+        for (uint8_t i = 0; i < State::FIELDS; i++)
+        {
+            Register reg;
+            memcpy_P(&reg, &REGISTERS[i], sizeof(reg));
+            bool dirty = image.dirty & (1 << i);
 
-        State::setJoy1Brightness(g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_JOY1_LED_BRIGHTNESS_ADDR));
-        State::setJoy2Brightness(g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_JOY2_LED_BRIGHTNESS_ADDR));
+            switch (reg.kind)
+            {
+            case Kind::COIL:
+                if (dirty)
+                {
+                    g_server.digitalWrite(COIL, reg.addr, image.values[i]);
+                }
+                else
+                {
+                    pull(image, i, g_server.digitalRead(COIL, reg.addr));
+                }
+                break;
+            case Kind::DISCRETE_INPUT:
+                if (dirty)
+                {
+                    g_server.digitalWrite(INPUT, reg.addr, image.values[i]);
+                }
+                break;
+            case Kind::HOLDING:
+                if (dirty)
+                {
+                    g_server.analogWrite(HOLDING_REG, reg.addr, image.values[i]);
+                }
+                else
+                {
+                    pull(image, i, g_server.analogRead(HOLDING_REG, reg.addr));
+                }
+                break;
+            case Kind::INPUT_REGISTER:
+                if (dirty)
+                {
+                    g_server.analogWrite(INPUT_REG, reg.addr, image.values[i]);
+                }
+                break;
+            }
+        }
+    }
 
-        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_MCU_GAMESEL_ADDR, State::getSelectorValue());
+    void pull(State::Image &image, uint8_t field, uint16_t value)
+    {
+        if (image.values[field] != value)
+        {
+            image.values[field] = value;
+            Cadence::activity();
+        }
     }
 
     void sbcHeartbeatCheck()
@@ -101,7 +475,7 @@ namespace Comm
         static uint16_t sbcHeartbeatCntr = 0;
 
         // Not enough time passed to perform next heartbead check
-        if (millis() - g_sbcHeartbeatCheckStamp < Config::Communication::SBC_HB_CHECK_PERIOD)
+        if (millis() - g_sbcHeartbeatCheckStamp < Settings::sbcHbCheckPeriod())
         {
             return;
         }
@@ -120,12 +494,12 @@ namespace Comm
                 g_sbcHeartbeatRetries++;
             }
 
-            if (g_sbcHeartbeatRetries >= Config::Communication::SBC_HB_MAX_RETRIES)
+            if (g_sbcHeartbeatRetries >= Settings::sbcHbMaxRetries())
             {
                 LOG_DEBUG(F("SBC nok"));
 
                 g_connected = false;
-                g_sbcHeartbeatRetries = Config::Communication::SBC_HB_MAX_RETRIES;
+                g_sbcHeartbeatRetries = Settings::sbcHbMaxRetries();
             }
         }
         else
@@ -135,6 +509,7 @@ namespace Comm
             g_sbcHeartbeatRetries = 0;
             g_connected = true;
             sbcHeartbeatCntr = val;
+            g_sbcHeartbeatStamp = millis();
         }
     }
 
@@ -144,4 +519,37 @@ namespace Comm
         g_mcuHeartbeatCntr++;
         g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_MCU_HB_CNTR_ADDR, g_mcuHeartbeatCntr);
     }
+
+    void updateDiag()
+    {
+        static uint8_t prevPage = 0;
+        uint8_t page = g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_DIAG_PAGE_ADDR);
+
+        Trace::acknowledge(g_server.analogRead(HOLDING_REG, Config::Communication::HoldingRegs::AQ_TRACE_ACK_ADDR));
+
+        // Don't leave values of previous page in registers the new page doesn't use
+        if (page != prevPage)
+        {
+            for (uint8_t i = 0; i < Config::Communication::InputRegs::DIAG_WINDOW_SIZE; i++)
+            {
+                writeDiag(i, 0);
+            }
+            prevPage = page;
+        }
+
+        Diag::fill(static_cast<Diag::Page>(page), writeDiag);
+
+        // Written last so SBC knows that the window holds requested page
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_DIAG_PAGE_ADDR, page);
+    }
+
+    void writeDiag(uint8_t idx, uint16_t val)
+    {
+        if (idx >= Config::Communication::InputRegs::DIAG_WINDOW_SIZE)
+        {
+            return;
+        }
+
+        g_server.analogWrite(INPUT_REG, Config::Communication::InputRegs::AI_DIAG_WINDOW_ADDR + idx, val);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "Diag.hpp"
+#include "Mutex.hpp"
+#include "State.hpp"
+#include "Log.hpp"
+#include "DisplayTask.hpp"
+#include "Trace.hpp"
+#include "Executor.hpp"
+#include "Power.hpp"
+#include "Boot.hpp"
+#include "Watchdog.hpp"
+#include "AppTask.hpp"
+#include "Cadence.hpp"
+#include "Config.hpp"
+
+namespace Diag
+{
+    void fill(Page page, Writer write);
+
+    /**
+     * @brief Write mutex counters into first 4 window registers.
+     */
+    void fillMutex(const Mutex::Stats &stats, Writer write);
+
+    /**
+     * @brief Write free RAM and executor job timing, jobs are zero with FreeRTOS.
+     */
+    void fillRuntime(Writer write);
+
+    /**
+     * @brief Write boot phase, history size, timeouts and phase times.
+     */
+    void fillBoot(Writer write);
+
+    /**
+     * @brief Write App state visits and transition latency.
+     */
+    void fillAppStates(Writer write);
+
+    void fill(Page page, Writer write)
+    {
+        switch (page)
+        {
+        case Page::IDLE:
+            break;
+        case Page::MUTEX_STATE:
+            fillMutex(State::getMutexStats(), write);
+            break;
+        case Page::MUTEX_LOG:
+            fillMutex(logger::getMutexStats(), write);
+            break;
+        case Page::MUTEX_DISP:
+            fillMutex(Disp::getMutexStats(), write);
+            break;
+        case Page::TRACE:
+            Trace::fill(write);
+            break;
+        case Page::RUNTIME:
+            fillRuntime(write);
+            break;
+        case Page::POWER:
+        {
+            Power::Stats stats = Power::stats();
+            write(0, stats.sleeps);
+            write(1, stats.lastLatency);
+            write(2, stats.maxLatency);
+            break;
+        }
+        case Page::BOOT:
+            fillBoot(write);
+            break;
+        case Page::WATCHDOG:
+        {
+            Watchdog::Stats stats = Watchdog::stats();
+            write(0, stats.faults);
+            write(1, stats.lastTask);
+            write(2, stats.lastOverdue);
+            write(3, stats.resetCause);
+            write(4, stats.warm);
+            break;
+        }
+        case Page::APP_STATES:
+            fillAppStates(write);
+            break;
+        case Page::CADENCE:
+        {
+            Cadence::Stats stats = Cadence::stats();
+            write(0, stats.period);
+            write(1, stats.mode);
+            for (uint8_t i = 0; i < Cadence::MODES; i++)
+            {
+                write(2 + i, stats.seconds[i]);
+            }
+            break;
+        }
+        }
+    }
+
+    void fillMutex(const Mutex::Stats &stats, Writer write)
+    {
+        write(0, stats.acquisitions);
+        write(1, stats.contended);
+        write(2, stats.waitTicks);
+        write(3, stats.timeouts);
+    }
+
+    void fillRuntime(Writer write)
+    {
+        write(0, Executor::freeRam());
+
+        for (uint8_t i = 0; i < Config::Executor::MAX_JOBS; i++)
+        {
+            Executor::Stats stats = Executor::stats(i);
+            write(1 + 4 * i, stats.runs);
+            write(2 + 4 * i, stats.maxLateness);
+            write(3 + 4 * i, stats.maxDuration);
+            write(4 + 4 * i, stats.freeStack);
+        }
+    }
+
+    void fillBoot(Writer write)
+    {
+        Boot::Stats stats = Boot::stats();
+        write(0, stats.phase);
+        write(1, stats.records);
+        write(2, stats.timeouts);
+
+        for (uint8_t i = 0; i < Boot::PHASES - 1; i++)
+        {
+            write(3 + 2 * i, stats.last[i]);
+            write(4 + 2 * i, stats.deadline[i]);
+        }
+
+        write(7, stats.shutdown);
+        write(8, stats.earlyCuts);
+        write(9, stats.lateCuts);
+        write(10, stats.lateFrontends);
+    }
+
+    void fillAppStates(Writer write)
+    {
+        App::Stats stats = App::stats();
+        for (uint8_t i = 0; i < App::STATES; i++)
+        {
+            write(2 * i, stats.states[i].entries);
+            write(2 * i + 1, stats.states[i].lastDwell);
+        }
+
+        write(10, stats.lastLatency);
+        write(11, stats.maxLatency);
+    }
+}
\ No newline at end of file
@@ -1,21 +1,44 @@
 #include "DisplayTask.hpp"
 #include <Arduino.h>
+#ifndef COOP_EXECUTOR
 #include <Arduino_FreeRTOS.h>
-#include <semphr.h>
+#include "Tick.hpp"
+#endif
+#include "Mutex.hpp"
 #include "Log.hpp"
-#include "State.hpp"
+#include "Settings.hpp"
 #include "Config.hpp"
+#include "Pin.hpp"
+#include "Watchdog.hpp"
 
 namespace
 {
-    bool ON = true;   // Used to check factual display state.
-    bool OFF = false; // Used to check factual display state.
+    // Logical true means that display is on.
+    typedef Pin<Config::DisplayTask::GPIO::DISP_DET, Config::DisplayTask::INVERT_DET> DetPin;
+    // Logical true simulates button press on display.
+    typedef Pin<Config::DisplayTask::GPIO::DISP_CTRL, Config::DisplayTask::INVERT_CTRL> CtrlPin;
 
-    bool RELEASED = false; // Used to simulate button press on display.
-    bool PRESSED = true;   // Used to simulate button press on display.
+    static_assert(DetPin::PORT == PORT_D, "Display detection must be handled by PCINT2_vect");
+
+    enum class DispState
+    {
+        IDLE,     // Compare requested and detected state.
+        CLICKING, // Simulated button is held.
+        SETTLING  // Waiting for display to reach requested state.
+    };
 
     bool m_focedOff = false;
-    SemaphoreHandle_t g_forceOffSemaphore = xSemaphoreCreateMutex();
+    Mutex g_forceOffMutex('D');
+
+    // Written by ISR.
+    volatile bool g_detLevel = false;
+    volatile unsigned long g_detEdgeStamp = 0;
+    volatile unsigned long g_detOffStamp = 0; // End of last dark period longer than glitch time.
+
+    DispState g_state = DispState::IDLE;
+    bool g_target = false; // State requested by last click.
+    unsigned long g_stateStamp = 0;
+    unsigned long g_clickStamp = 0;
 }
 
 namespace Disp
@@ -23,107 +46,185 @@ namespace Disp
     void task(void *pvParameters __attribute__((unused)));
     void forceOff();
     void removeForceOff();
+    Mutex::Stats getMutexStats();
+    void detEdge();
+    void init();
+    void step();
 
     /**
-     * @brief Simulate button click with delay.
+     * @brief Whether display should be on according to State and force off.
      */
-    void click();
+    bool requested();
+
+    /**
+     * @brief Glitch filtered detection level.
+     *
+     * @param lastOff Set to millis() when display was last seen dark.
+     */
+    bool detected(unsigned long &lastOff);
 
     /**
      * @brief Log stack usage periodically.
      */
     void logHighwater();
 
+#ifndef COOP_EXECUTOR
     void task(void *pvParameters __attribute__((unused)))
     {
-        if (Config::DisplayTask::INVERT_DET)
-        {
-            ON = false;
-            OFF = true;
-        }
-        if (Config::DisplayTask::INVERT_CTRL)
+        init();
+
+        while (true)
         {
-            PRESSED = false;
-            RELEASED = true;
+            step();
+
+            // logHighwater();
+
+            vTaskDelay(Tick::fromMs(Config::DisplayTask::LOOP_DELAY));
         }
+    }
+#endif
 
-        pinMode(Config::DisplayTask::GPIO::DISP_CTRL, OUTPUT);
-        pinMode(Config::DisplayTask::GPIO::DISP_DET, INPUT);
+    void init()
+    {
+        CtrlPin::output();
+        DetPin::input();
 
-        digitalWrite(Config::DisplayTask::GPIO::DISP_CTRL, RELEASED);
+        CtrlPin::write(false);
 
-        while (true)
+        noInterrupts();
+        g_detLevel = DetPin::read();
+        g_detEdgeStamp = millis();
+        g_detOffStamp = g_detEdgeStamp; // Unknown history, don't trust display is on yet
+        interrupts();
+
+        DetPin::enableChangeInterrupt();
+    }
+
+    void step()
+    {
+        unsigned long now = millis();
+        unsigned long lastOff;
+        bool lit = detected(lastOff);
+        bool want = requested();
+
+        switch (g_state)
         {
-            bool forcedOff = false;
-            if (xSemaphoreTake(g_forceOffSemaphore, (TickType_t)5) == pdTRUE)
+        case DispState::IDLE:
+            // Display may blink detection while off, so it's only considered on if lit for a while
+            if (want ? !lit : now - lastOff >= Settings::disableCheckDuration())
             {
-                forcedOff = m_focedOff;
-                xSemaphoreGive(g_forceOffSemaphore);
-            }
+                CtrlPin::write(true);
+                g_target = want;
+                g_state = DispState::CLICKING;
+                g_stateStamp = now;
+                g_clickStamp = now;
 
-            if (State::getDisplayState() && !forcedOff)
-            {
-                if (digitalRead(Config::DisplayTask::GPIO::DISP_DET) == OFF)
+                if (want)
                 {
-                    click();
-
                     LOG_ERROR(F("Disp on"));
-
-                    vTaskDelay(pdMS_TO_TICKS(Config::DisplayTask::STATE_TRANSITION_DELAY));
                 }
-            }
-            else
-            {
-                bool isOff = false;
-                for (uint8_t i = 0; i < Config::DisplayTask::DISABLE_CHECK_DURATION / Config::DisplayTask::LOOP_DELAY; i++)
+                else
                 {
-                    if (digitalRead(Config::DisplayTask::GPIO::DISP_DET) == OFF)
-                    {
-                        isOff = true;
-                        break;
-                    }
-                    vTaskDelay(pdMS_TO_TICKS(Config::DisplayTask::LOOP_DELAY));
+                    LOG_ERROR(F("Disp off"));
                 }
+            }
+            break;
 
-                if (!isOff)
-                {
-                    click();
-
-                    LOG_ERROR(F("Disp off"));
+        case DispState::CLICKING:
+            if (now - g_stateStamp >= Settings::clickTime())
+            {
+                CtrlPin::write(false);
+                g_state = DispState::SETTLING;
+                g_stateStamp = now;
+            }
+            break;
 
-                    vTaskDelay(pdMS_TO_TICKS(Config::DisplayTask::STATE_TRANSITION_DELAY));
-                }
+        case DispState::SETTLING:
+            // Request changed or display already got there, it went dark since click if turning off
+            if (want != g_target ||
+                (g_target ? lit : (long)(lastOff - g_clickStamp) >= 0) ||
+                now - g_stateStamp >= Settings::stateTransitionDelay())
+            {
+                g_state = DispState::IDLE;
             }
+            break;
+        }
 
-            // logHighwater();
+        Watchdog::checkIn(Watchdog::Task::DISP);
+    }
+
+    bool requested()
+    {
+        bool forcedOff = false;
+        if (g_forceOffMutex.take())
+        {
+            forcedOff = m_focedOff;
+            g_forceOffMutex.give();
+        }
+
+        // Display stays on whatever SBC or scene requests, State keeps the request so SBC reads it back
+        return !forcedOff;
+    }
+
+    bool detected(unsigned long &lastOff)
+    {
+        noInterrupts();
+        bool level = g_detLevel;
+        unsigned long edgeStamp = g_detEdgeStamp;
+        lastOff = g_detOffStamp;
+        interrupts();
+
+        unsigned long now = millis();
 
-            vTaskDelay(pdMS_TO_TICKS(Config::DisplayTask::LOOP_DELAY));
+        // Level younger than glitch time may still flip back
+        bool lit = now - edgeStamp >= Config::DisplayTask::DET_GLITCH_TIME ? level : !level;
+        if (!lit)
+        {
+            lastOff = now;
         }
+
+        return lit;
+    }
+
+    void detEdge()
+    {
+        bool level = DetPin::read();
+        if (level == g_detLevel)
+        {
+            return;
+        }
+
+        unsigned long now = millis();
+        if (level && now - g_detEdgeStamp >= Config::DisplayTask::DET_GLITCH_TIME)
+        {
+            g_detOffStamp = now;
+        }
+
+        g_detLevel = level;
+        g_detEdgeStamp = now;
     }
 
     void forceOff()
     {
-        if (xSemaphoreTake(g_forceOffSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_forceOffMutex.take())
         {
             m_focedOff = true;
-            xSemaphoreGive(g_forceOffSemaphore);
+            g_forceOffMutex.give();
         }
     }
 
     void removeForceOff()
     {
-        if (xSemaphoreTake(g_forceOffSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_forceOffMutex.take())
         {
             m_focedOff = false;
-            xSemaphoreGive(g_forceOffSemaphore);
+            g_forceOffMutex.give();
         }
     }
 
-    void click()
+    Mutex::Stats getMutexStats()
     {
-        digitalWrite(Config::DisplayTask::GPIO::DISP_CTRL, PRESSED);
-        vTaskDelay(pdMS_TO_TICKS(400));
-        digitalWrite(Config::DisplayTask::GPIO::DISP_CTRL, RELEASED);
+        return g_forceOffMutex.stats();
     }
 
     void logHighwater()
@@ -133,8 +234,10 @@ namespace Disp
 
         if (millis() - stamp >= period)
         {
+#ifndef COOP_EXECUTOR
             uint16_t uxHighWaterMark = uxTaskGetStackHighWaterMark(NULL);
             LOG_INFO(String(F("disp: ")) + String(uxHighWaterMark));
+#endif
             stamp = millis();
         }
     }
@@ -0,0 +1,139 @@
+#include "Executor.hpp"
+#include "Config.hpp"
+#ifdef COOP_EXECUTOR
+#include <avr/sleep.h>
+
+namespace
+{
+    struct Slot
+    {
+        Executor::Job job;
+        uint16_t period;
+        unsigned long due;
+        Executor::Stats stats;
+    };
+
+    Slot g_slots[Config::Executor::MAX_JOBS];
+    uint8_t g_numSlots = 0;
+}
+#else
+namespace
+{
+    TaskHandle_t g_tasks[Config::Executor::MAX_JOBS];
+    uint8_t g_numTasks = 0;
+}
+#endif
+
+extern char *__brkval;
+extern char __heap_start;
+
+namespace Executor
+{
+#ifdef COOP_EXECUTOR
+    void add(Job job, uint16_t period);
+    void setPeriod(Job job, uint16_t period);
+    void run();
+    Stats stats(uint8_t idx);
+#else
+    void addTask(TaskHandle_t task);
+    Stats stats(uint8_t idx);
+#endif
+    uint16_t freeRam();
+
+#ifdef COOP_EXECUTOR
+    void add(Job job, uint16_t period)
+    {
+        if (g_numSlots >= Config::Executor::MAX_JOBS)
+        {
+            return;
+        }
+
+        g_slots[g_numSlots].job = job;
+        g_slots[g_numSlots].period = period;
+        g_slots[g_numSlots].due = millis();
+        g_numSlots++;
+    }
+
+    void setPeriod(Job job, uint16_t period)
+    {
+        for (uint8_t i = 0; i < g_numSlots; i++)
+        {
+            if (g_slots[i].job == job)
+            {
+                g_slots[i].period = period;
+            }
+        }
+    }
+
+    void run()
+    {
+        for (uint8_t i = 0; i < g_numSlots; i++)
+        {
+            Slot &slot = g_slots[i];
+
+            unsigned long late = millis() - slot.due;
+            if ((long)late < 0)
+            {
+                continue;
+            }
+
+            unsigned long start = micros();
+            slot.job();
+            unsigned long duration = micros() - start;
+
+            slot.stats.runs++;
+            slot.stats.maxLateness = max(slot.stats.maxLateness, (uint16_t)min(late, 0xFFFFUL));
+            slot.stats.maxDuration = max(slot.stats.maxDuration, (uint16_t)min(duration, 0xFFFFUL));
+
+            // Skip missed periods instead of running the job back to back
+            slot.due += slot.period;
+            if ((long)(millis() - slot.due) >= 0)
+            {
+                slot.due = millis() + slot.period;
+            }
+        }
+
+        // Timer0 overflow wakes CPU at least every ms
+        set_sleep_mode(SLEEP_MODE_IDLE);
+        sleep_mode();
+    }
+
+    Stats stats(uint8_t idx)
+    {
+        return idx < g_numSlots ? g_slots[idx].stats : Stats();
+    }
+#else
+    void addTask(TaskHandle_t task)
+    {
+        if (g_numTasks >= Config::Executor::MAX_JOBS)
+        {
+            return;
+        }
+
+        g_tasks[g_numTasks++] = task;
+    }
+
+    Stats stats(uint8_t idx)
+    {
+        Stats stats;
+        if (idx < g_numTasks)
+        {
+            stats.freeStack = uxTaskGetStackHighWaterMark(g_tasks[idx]);
+        }
+
+        return stats;
+    }
+#endif
+
+    uint16_t freeRam()
+    {
+        char *heapEnd = __brkval ? __brkval : &__heap_start;
+#ifdef COOP_EXECUTOR
+        char top;
+        return &top - heapEnd;
+#else
+        // Local would be on task stack inside .bss, only scheduler start frames are left on main stack
+        return reinterpret_cast<char *>(RAMEND) + 1 - heapEnd;
+#endif
+    }
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "LightEffectors.hpp"
 #include "SoftPWM.hpp"
+#include "Settings.hpp"
 #include "Config.hpp"
 
 LightEffectors::LightEffectors(uint8_t pin1, uint8_t pin2) : m_pin1(pin1), m_pin2(pin2)
@@ -42,7 +43,7 @@ void LightEffectors::update()
         SoftPwmWrite(m_pin2, 0);
         break;
     case Effect::BLINKING:
-        updatePwm(delta, Config::LightEffector::BLINKING_RATIO);
+        updatePwm(delta, Settings::blinkingRatio());
 
         SoftPwmWrite(m_pin1, m_pwmEffectVal);
         SoftPwmWrite(m_pin2, m_pwmEffectVal);
@@ -52,22 +53,38 @@ void LightEffectors::update()
         SoftPwmWrite(m_pin2, m_pwmVal2);
         break;
     case Effect::ALTERNATING_BLINKING:
-        updatePwm(delta, Config::LightEffector::BLINKING_RATIO);
+        updatePwm(delta, Settings::blinkingRatio());
 
         SoftPwmWrite(m_pin1, m_pwmEffectVal);
         SoftPwmWrite(m_pin2, 255 - m_pwmEffectVal);
         break;
     case Effect::FAST_BLINKING:
-        updatePwm(delta, Config::LightEffector::FAST_BLINKING_RATIO);
+        updatePwm(delta, Settings::fastBlinkingRatio());
 
         SoftPwmWrite(m_pin1, m_pwmEffectVal);
         SoftPwmWrite(m_pin2, m_pwmEffectVal);
         break;
+    case Effect::STREAM:
+        SoftPwmWrite(m_pin1, m_frameVal1);
+        SoftPwmWrite(m_pin2, m_frameVal2);
+        break;
     }
 
     m_effectStamp = millis();
 }
 
+void LightEffectors::setFrame(uint8_t val1, uint8_t val2)
+{
+    m_frameVal1 = val1;
+    m_frameVal2 = val2;
+
+    if (m_effect == Effect::STREAM)
+    {
+        SoftPwmWrite(m_pin1, m_frameVal1);
+        SoftPwmWrite(m_pin2, m_frameVal2);
+    }
+}
+
 void LightEffectors::updatePwm(unsigned long delta, float ratio)
 {
     float pwm = m_pwmEffectVal;
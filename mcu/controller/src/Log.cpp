@@ -1,12 +1,11 @@
 #include "Log.hpp"
-#include <Arduino_FreeRTOS.h>
-#include <semphr.h>
+#include "Mutex.hpp"
 
 #if LOG_LEVEL != NONE
 namespace
 {
     SoftwareSerial *g_stream;
-    SemaphoreHandle_t g_logSemapthore = xSemaphoreCreateMutex();
+    Mutex g_logMutex('L');
 }
 
 namespace logger
@@ -16,45 +15,59 @@ namespace logger
         g_stream = &stream;
     }
 
+    Mutex::Stats getMutexStats()
+    {
+        return g_logMutex.stats();
+    }
 }
 
 void logDebug(String s)
 {
-    if (xSemaphoreTake(g_logSemapthore, (TickType_t)5) == pdTRUE)
+    if (g_logMutex.take())
     {
         g_stream->print(F("D: "));
         g_stream->println(s);
-        xSemaphoreGive(g_logSemapthore);
+        g_logMutex.give();
     }
 }
 
 void logInfo(String s)
 {
-    if (xSemaphoreTake(g_logSemapthore, (TickType_t)5) == pdTRUE)
+    if (g_logMutex.take())
     {
         g_stream->print(F("I: "));
         g_stream->println(s);
-        xSemaphoreGive(g_logSemapthore);
+        g_logMutex.give();
     }
 }
 
 void logWarning(String s)
 {
-    if (xSemaphoreTake(g_logSemapthore, (TickType_t)5) == pdTRUE)
+    if (g_logMutex.take())
     {
         g_stream->print(F("W: "));
         g_stream->println(s);
-        xSemaphoreGive(g_logSemapthore);
+        g_logMutex.give();
     }
 }
 
 void logError(String s)
 {
-    if (xSemaphoreTake(g_logSemapthore, (TickType_t)5) == pdTRUE)
+    if (g_logMutex.take())
     {
         g_stream->print(F("E: "));
         g_stream->println(s);
-        xSemaphoreGive(g_logSemapthore);
+        g_logMutex.give();
+    }
+}
+#endif
+
+#if LOG_LEVEL == NONE
+namespace logger
+{
+    Mutex::Stats getMutexStats()
+    {
+        return Mutex::Stats();
     }
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "Mutex.hpp"
+#include "Config.hpp"
+#include "Trace.hpp"
+
+#ifndef COOP_EXECUTOR
+#include "Tick.hpp"
+
+Mutex::Mutex(char traceName) : m_handle(xSemaphoreCreateMutexStatic(&m_buffer))
+{
+    Trace::nameObject(m_handle, traceName);
+}
+
+bool Mutex::take()
+{
+    // Fast path, no one holds the mutex so only the owner touches the counters. Failed
+    // zero wait take would be traced as timeout, so it's tried only when it can't fail.
+    vTaskSuspendAll();
+    bool free = xSemaphoreGetMutexHolder(m_handle) == nullptr && xSemaphoreTake(m_handle, 0) == pdTRUE;
+    xTaskResumeAll();
+
+    if (free)
+    {
+        m_stats.acquisitions++;
+        return true;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    bool res = xSemaphoreTake(m_handle, Tick::fromMs(Config::Sync::MUTEX_TIMEOUT)) == pdTRUE;
+    TickType_t waited = xTaskGetTickCount() - start;
+
+    // Timed out task writes counters while someone else holds the mutex.
+    taskENTER_CRITICAL();
+    m_stats.waitTicks += waited;
+    if (res)
+    {
+        m_stats.acquisitions++;
+        m_stats.contended++;
+    }
+    else
+    {
+        m_stats.timeouts++;
+    }
+    taskEXIT_CRITICAL();
+
+    return res;
+}
+
+void Mutex::give()
+{
+    xSemaphoreGive(m_handle);
+}
+
+Mutex::Stats Mutex::stats()
+{
+    taskENTER_CRITICAL();
+    Stats res = m_stats;
+    taskEXIT_CRITICAL();
+
+    return res;
+}
+#else
+Mutex::Mutex(char traceName __attribute__((unused)))
+{
+}
+
+bool Mutex::take()
+{
+    m_stats.acquisitions++;
+    return true;
+}
+
+void Mutex::give()
+{
+}
+
+Mutex::Stats Mutex::stats()
+{
+    return m_stats;
+}
+#endif
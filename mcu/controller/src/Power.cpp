@@ -0,0 +1,120 @@
+#include "Power.hpp"
+#include <avr/sleep.h>
+#include "SoftPWM.hpp"
+#include "Pin.hpp"
+#include "Watchdog.hpp"
+#include "Config.hpp"
+#ifndef COOP_EXECUTOR
+#include "Tick.hpp"
+#endif
+
+namespace
+{
+    typedef Pin<0> RxPin; // UART RX, start bit wakes CPU but the byte itself is lost.
+
+    volatile bool g_allowed = false;
+    volatile bool g_pending = false; // Woke up, App didn't handle it yet.
+    volatile unsigned long g_wakeStamp = 0; // millis() of last wake.
+    volatile unsigned long g_wakeMicros = 0;
+
+    Power::Stats g_stats;
+}
+
+namespace Power
+{
+    void setSleepAllowed(bool allowed);
+    void idle();
+    void handled();
+    Stats stats();
+
+    void setSleepAllowed(bool allowed)
+    {
+        g_allowed = allowed;
+    }
+
+    void idle()
+    {
+        if (!g_allowed)
+        {
+            return;
+        }
+
+        // Stay awake for a while so debouncers see time pass after the edge that woke us
+        if (g_pending || millis() - g_wakeStamp < Config::Power::WAKE_HOLD)
+        {
+            return;
+        }
+
+        Serial.flush();
+
+        SoftPwmSuspend();
+#ifndef COOP_EXECUTOR
+        Tick::suspend();
+#endif
+        Watchdog::suspend();
+        uint8_t adc = ADCSRA;
+        ADCSRA = 0;
+
+        RxPin::enableChangeInterrupt();
+
+        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+        cli();
+        bool slept = g_allowed; // App may have changed its mind meanwhile
+        if (slept)
+        {
+            sleep_enable();
+            sleep_bod_disable();
+            sei();
+            sleep_cpu(); // sei takes effect after this instruction, wake can't slip in before sleep
+            sleep_disable();
+        }
+        sei();
+
+        if (slept)
+        {
+            g_wakeMicros = micros();
+            g_wakeStamp = millis();
+        }
+
+        RxPin::changeMaskReg() &= ~RxPin::MASK;
+
+        ADCSRA = adc;
+        Watchdog::resume();
+#ifndef COOP_EXECUTOR
+        Tick::resume();
+#endif
+        SoftPwmResume();
+
+        if (slept)
+        {
+            g_stats.sleeps++;
+            g_pending = true;
+        }
+    }
+
+    void handled()
+    {
+        if (!g_pending)
+        {
+            return;
+        }
+
+        unsigned long latency = micros() - g_wakeMicros;
+
+        noInterrupts();
+        g_stats.lastLatency = min(latency, 0xFFFFUL);
+        g_stats.maxLatency = max(g_stats.maxLatency, g_stats.lastLatency);
+        interrupts();
+
+        g_pending = false;
+    }
+
+    Stats stats()
+    {
+        noInterrupts();
+        Stats res = g_stats;
+        interrupts();
+
+        return res;
+    }
+}
\ No newline at end of file
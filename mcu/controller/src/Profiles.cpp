@@ -0,0 +1,94 @@
+#include "Profiles.hpp"
+#include <EEPROM.h>
+#include "Config.hpp"
+
+namespace
+{
+    constexpr uint8_t RECORD_SIZE = 4;
+    constexpr uint8_t CHECK_SEED = 0xA5; // Erased EEPROM (all 0xFF) doesn't pass the check.
+
+    struct Record
+    {
+        uint8_t flags; // Bit 0 joy1, 1 joy2, 4..7 effect.
+        uint8_t joy1Brightness;
+        uint8_t joy2Brightness;
+        uint8_t check;
+    };
+
+    static_assert(sizeof(Record) == RECORD_SIZE, "Record layout");
+    static_assert(Config::Profiles::EEPROM_ADDR + Config::Profiles::COUNT * RECORD_SIZE <= 1024, "Profiles don't fit EEPROM");
+}
+
+namespace Profiles
+{
+    bool get(uint16_t slot, Profile &profile);
+    void store(uint16_t slot, const Profile &profile);
+    void erase(uint16_t slot);
+
+    uint8_t check(const Record &record);
+    int address(uint16_t slot);
+
+    bool get(uint16_t slot, Profile &profile)
+    {
+        if (slot >= Config::Profiles::COUNT)
+        {
+            return false;
+        }
+
+        Record record;
+        EEPROM.get(address(slot), record);
+
+        if (record.check != check(record))
+        {
+            return false;
+        }
+
+        profile.joy1Enable = record.flags & (1 << 0);
+        profile.joy2Enable = record.flags & (1 << 1);
+        profile.effect = record.flags >> 4;
+        profile.joy1Brightness = record.joy1Brightness;
+        profile.joy2Brightness = record.joy2Brightness;
+
+        return true;
+    }
+
+    void store(uint16_t slot, const Profile &profile)
+    {
+        if (slot >= Config::Profiles::COUNT)
+        {
+            return;
+        }
+
+        Record record;
+        record.flags = (profile.joy1Enable << 0) | (profile.joy2Enable << 1) | (profile.effect << 4);
+        record.joy1Brightness = profile.joy1Brightness;
+        record.joy2Brightness = profile.joy2Brightness;
+        record.check = check(record);
+
+        EEPROM.put(address(slot), record);
+    }
+
+    void erase(uint16_t slot)
+    {
+        if (slot >= Config::Profiles::COUNT)
+        {
+            return;
+        }
+
+        Record record;
+        EEPROM.get(address(slot), record);
+
+        // Breaking the check is enough, single byte write
+        EEPROM.update(address(slot) + RECORD_SIZE - 1, ~check(record));
+    }
+
+    uint8_t check(const Record &record)
+    {
+        return CHECK_SEED ^ record.flags ^ record.joy1Brightness ^ record.joy2Brightness;
+    }
+
+    int address(uint16_t slot)
+    {
+        return Config::Profiles::EEPROM_ADDR + slot * RECORD_SIZE;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "Resume.hpp"
+#include <EEPROM.h>
+#include "Config.hpp"
+
+namespace
+{
+    constexpr uint8_t CHECK_SEED = 0x5A; // Erased EEPROM (all 0xFF) doesn't pass the check.
+
+    struct Record
+    {
+        uint8_t powered;
+        uint16_t slot;
+        uint16_t maxSlot;
+        uint8_t check;
+    };
+
+    static_assert(Config::Resume::EEPROM_ADDR + sizeof(Record) <= 1024, "Resume state doesn't fit EEPROM");
+
+    Resume::Snapshot g_snapshot;
+}
+
+namespace Resume
+{
+    bool init();
+    Snapshot get();
+    void setPowered(bool powered);
+    void setSlot(uint16_t slot);
+    void setMaxSlot(uint16_t maxSlot);
+
+    void save();
+    uint8_t check(const Record &record);
+
+    bool init()
+    {
+        Record record;
+        EEPROM.get(Config::Resume::EEPROM_ADDR, record);
+
+        if (record.check != check(record))
+        {
+            return false;
+        }
+
+        g_snapshot.powered = record.powered;
+        g_snapshot.slot = record.slot;
+        g_snapshot.maxSlot = record.maxSlot;
+
+        return true;
+    }
+
+    Snapshot get()
+    {
+        return g_snapshot;
+    }
+
+    void setPowered(bool powered)
+    {
+        if (powered == g_snapshot.powered)
+        {
+            return;
+        }
+        g_snapshot.powered = powered;
+
+        save();
+    }
+
+    void setSlot(uint16_t slot)
+    {
+        if (slot == g_snapshot.slot)
+        {
+            return;
+        }
+        g_snapshot.slot = slot;
+
+        save();
+    }
+
+    void setMaxSlot(uint16_t maxSlot)
+    {
+        if (maxSlot == g_snapshot.maxSlot)
+        {
+            return;
+        }
+        g_snapshot.maxSlot = maxSlot;
+
+        save();
+    }
+
+    void save()
+    {
+        Record record;
+        record.powered = g_snapshot.powered;
+        record.slot = g_snapshot.slot;
+        record.maxSlot = g_snapshot.maxSlot;
+        record.check = check(record);
+
+        EEPROM.put(Config::Resume::EEPROM_ADDR, record);
+    }
+
+    uint8_t check(const Record &record)
+    {
+        return CHECK_SEED ^ record.powered ^ (record.slot & 0xFF) ^ (record.slot >> 8) ^
+               (record.maxSlot & 0xFF) ^ (record.maxSlot >> 8);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "Settings.hpp"
+#include <EEPROM.h>
+#include <util/crc16.h>
+#include "Config.hpp"
+
+namespace
+{
+    struct Limits
+    {
+        uint16_t def;
+        uint16_t min;
+        uint16_t max;
+    };
+
+    // Indexed by Settings::Field, defaults converted to register units
+    const Limits LIMITS[Settings::COUNT] PROGMEM = {
+        {Config::AppTask::BOOT_TIMEOUT_DURATION / 1000, 10, 3600},
+        {Config::AppTask::SHUTDOWN_DURATION / 1000, 5, 600},
+        {Config::Communication::SBC_HB_CHECK_PERIOD, 100, 60000},
+        {Config::Communication::SBC_HB_MAX_RETRIES, 1, 255},
+        {Config::Communication::SERIAL_BAUD / 100, 12, 1152},
+        {(uint16_t)(Config::LightEffector::BLINKING_RATIO * 1000), 1, 10000},
+        {(uint16_t)(Config::LightEffector::FAST_BLINKING_RATIO * 1000), 1, 10000},
+        {Config::DisplayTask::DISABLE_CHECK_DURATION, 100, 30000},
+        {Config::DisplayTask::STATE_TRANSITION_DELAY, 100, 30000},
+        {Config::DisplayTask::CLICK_TIME, 20, 5000},
+        {Config::PwrButton::CLICK_TIMEOUT, 50, 5000},
+        {Config::Resume::MODE, Config::Resume::MODE_OFF, Config::Resume::MODE_ALWAYS},
+        {Config::Resume::WAKE_ON_SELECT ? 2 : 1, 1, 2},
+    };
+
+    struct Block
+    {
+        uint8_t version;
+        uint16_t values[Settings::COUNT];
+        uint16_t crc;
+    };
+
+    // Standard rates in 100 baud, anything else would be a typo locking SBC out
+    const uint16_t BAUDS[] PROGMEM = {12, 24, 48, 96, 192, 384, 576, 1152};
+
+    static_assert(Config::Profiles::EEPROM_ADDR + Config::Profiles::COUNT * 4 <= Config::Settings::EEPROM_ADDR,
+                  "Settings overlap profiles");
+    static_assert(Config::Settings::EEPROM_ADDR + sizeof(Block) <= Config::Boot::EEPROM_ADDR, "Settings overlap boot history");
+    static_assert(Settings::COUNT == Config::Communication::HoldingRegs::SETTINGS_SIZE, "Settings registers");
+
+    static_assert(Config::Communication::SERIAL_BAUD % 100 == 0, "Compiled baud must be whole 100 baud");
+
+    uint16_t g_values[Settings::COUNT]; // Written only by App task, read by any.
+    bool g_stored = false;
+}
+
+namespace Settings
+{
+    void init();
+    uint16_t get(Field field);
+    void store(const uint16_t values[COUNT]);
+    bool stored();
+    void useDefaultBaud();
+
+    /**
+     * @brief Value itself if it's within field limits, otherwise field default.
+     */
+    uint16_t validate(uint8_t idx, uint16_t value);
+    bool standardBaud(uint16_t value);
+    uint16_t crc(const Block &block);
+
+    void init()
+    {
+        Block block;
+        EEPROM.get(Config::Settings::EEPROM_ADDR, block);
+
+        g_stored = block.version == Config::Settings::VERSION && block.crc == crc(block);
+
+        for (uint8_t i = 0; i < COUNT; i++)
+        {
+            g_values[i] = validate(i, g_stored ? block.values[i] : 0);
+        }
+    }
+
+    uint16_t get(Field field)
+    {
+        uint8_t idx = static_cast<uint8_t>(field);
+
+        // Display task may be preempted by store() in the middle of 16 bit read
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t res = g_values[idx];
+        SREG = sreg;
+
+        return res;
+    }
+
+    void store(const uint16_t values[COUNT])
+    {
+        Block block;
+        block.version = Config::Settings::VERSION;
+
+        for (uint8_t i = 0; i < COUNT; i++)
+        {
+            block.values[i] = validate(i, values[i]);
+        }
+        block.crc = crc(block);
+
+        uint8_t sreg = SREG;
+        cli();
+        memcpy(g_values, block.values, sizeof(g_values));
+        SREG = sreg;
+
+        EEPROM.put(Config::Settings::EEPROM_ADDR, block);
+        g_stored = true;
+    }
+
+    bool stored()
+    {
+        return g_stored;
+    }
+
+    void useDefaultBaud()
+    {
+        g_values[static_cast<uint8_t>(Field::SERIAL_BAUD)] = pgm_read_word(&LIMITS[static_cast<uint8_t>(Field::SERIAL_BAUD)].def);
+    }
+
+    uint16_t validate(uint8_t idx, uint16_t value)
+    {
+        if (value < pgm_read_word(&LIMITS[idx].min) || value > pgm_read_word(&LIMITS[idx].max) ||
+            (idx == static_cast<uint8_t>(Field::SERIAL_BAUD) && !standardBaud(value)))
+        {
+            return pgm_read_word(&LIMITS[idx].def);
+        }
+
+        return value;
+    }
+
+    bool standardBaud(uint16_t value)
+    {
+        for (uint8_t i = 0; i < sizeof(BAUDS) / sizeof(BAUDS[0]); i++)
+        {
+            if (pgm_read_word(&BAUDS[i]) == value)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint16_t crc(const Block &block)
+    {
+        uint16_t res = 0xFFFF; // Erased EEPROM (all 0xFF) doesn't pass the check.
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&block);
+
+        for (uint8_t i = 0; i < offsetof(Block, crc); i++)
+        {
+            res = _crc16_update(res, bytes[i]);
+        }
+
+        return res;
+    }
+
+    unsigned long bootTimeout()
+    {
+        return get(Field::BOOT_TIMEOUT) * 1000UL;
+    }
+
+    unsigned long shutdownDuration()
+    {
+        return get(Field::SHUTDOWN_DURATION) * 1000UL;
+    }
+
+    unsigned long sbcHbCheckPeriod()
+    {
+        return get(Field::SBC_HB_CHECK_PERIOD);
+    }
+
+    uint8_t sbcHbMaxRetries()
+    {
+        return get(Field::SBC_HB_MAX_RETRIES);
+    }
+
+    unsigned long serialBaud()
+    {
+        return get(Field::SERIAL_BAUD) * 100UL;
+    }
+
+    float blinkingRatio()
+    {
+        return get(Field::BLINKING_RATIO) / 1000.0;
+    }
+
+    float fastBlinkingRatio()
+    {
+        return get(Field::FAST_BLINKING_RATIO) / 1000.0;
+    }
+
+    unsigned long disableCheckDuration()
+    {
+        return get(Field::DISABLE_CHECK_DURATION);
+    }
+
+    unsigned long stateTransitionDelay()
+    {
+        return get(Field::STATE_TRANSITION_DELAY);
+    }
+
+    unsigned long clickTime()
+    {
+        return get(Field::CLICK_TIME);
+    }
+
+    unsigned long clickTimeout()
+    {
+        return get(Field::CLICK_TIMEOUT);
+    }
+
+    uint8_t resumeMode()
+    {
+        return get(Field::RESUME_MODE);
+    }
+
+    bool wakeOnSelect()
+    {
+        return get(Field::WAKE_ON_SELECT) == 2;
+    }
+}
\ No newline at end of file
@@ -7,19 +7,20 @@ namespace
 
     volatile uint8_t g_numUsedPins = 0;
     volatile uint8_t g_usedPins[Config::PWM::NUM_MCU_PINS];
-    volatile uint8_t g_vals[Config::PWM::NUM_MCU_PINS];
+    volatile uint8_t g_vals[Config::PWM::NUM_MCU_PINS]; // Values of running period, ISR only.
+    volatile uint8_t g_next[Config::PWM::NUM_MCU_PINS]; // Latched at start of next period, so one period never mixes two values.
 }
 
 ISR(TIMER1_COMPA_vect)
 {
     static uint16_t cntr = 0;
-    TCNT1 = 0;
 
     cntr++;
     if (cntr == 256)
     {
         for (uint8_t i = 0; i < g_numUsedPins; i++)
         {
+            g_vals[i] = g_next[i];
             if (g_vals[i] != 0)
             {
                 uint8_t bit = digitalPinToBitMask(g_usedPins[i]);
@@ -51,17 +52,18 @@ void SoftPwmInit()
     {
         g_usedPins[i] = FREE_PIN;
         g_vals[i] = 0;
+        g_next[i] = 0;
     }
 
     cli();
-    // Reset timer from Arduino stuff
+    // Reset timer from Arduino stuff, Timer1 is owned by soft PWM alone (Timer2 is display and optional FreeRTOS tick)
     TCCR1A = 0;
     TCNT1 = 0;
 
-    // 64 prescaler
-    TCCR1A |= (1 << CS11) | (1 << CS10);
+    // CTC, 64 prescaler
+    TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
 
-    // 2 ticks per ISR
+    // ISR every 3 timer ticks (12 us), cleared by hardware
     OCR1A = 2;
 
     TIMSK1 |= (1 << OCIE1A);
@@ -90,6 +92,7 @@ void SoftPWMAttach(uint8_t pin)
 
             g_usedPins[i] = pin;
             g_vals[i] = 0;
+            g_next[i] = 0;
             g_numUsedPins++;
             break;
         }
@@ -124,8 +127,26 @@ void SoftPwmWrite(uint8_t pin, uint8_t val)
     {
         if (g_usedPins[i] == pin)
         {
-            g_vals[i] = val;
+            g_next[i] = val;
             break;
         }
     }
+}
+
+void SoftPwmSuspend()
+{
+    TIMSK1 &= ~(1 << OCIE1A);
+
+    for (uint8_t i = 0; i < Config::PWM::NUM_MCU_PINS; i++)
+    {
+        if (g_usedPins[i] != FREE_PIN)
+        {
+            digitalWrite(g_usedPins[i], LOW);
+        }
+    }
+}
+
+void SoftPwmResume()
+{
+    TIMSK1 |= (1 << OCIE1A);
 }
\ No newline at end of file
@@ -1,195 +1,235 @@
 #include "State.hpp"
-#include <Arduino_FreeRTOS.h>
-#include <semphr.h>
+#include "Mutex.hpp"
 
 namespace
 {
-    bool g_shutdownReq = false; // from MCU to sbc
-    bool g_shutdownFlag = false;
-    bool g_displayState = false;
-    bool g_joy1Enable = false;
-    bool g_joy2Enable = false;
-    uint8_t g_joy1Brightness = 0;
-    uint8_t g_joy2Brightness = 0;
-    uint8_t g_selectorValue = 0;
-
-    SemaphoreHandle_t g_paramSemaphore = xSemaphoreCreateMutex();
-}
+    static_assert(static_cast<uint8_t>(State::Field::SELECTOR_DWELL) + 1 == State::FIELDS, "State::FIELDS must match Field");
+    static_assert(State::FIELDS <= 16, "Dirty bits must fit uint16_t");
 
-namespace State
-{
-    bool getShutdownRequest()
+    State::Image g_image = {};
+    State::Scene g_scene;
+    bool g_scenePending = false;
+    State::Frame g_frame;
+    bool g_framePending = false;
+
+    Mutex g_paramMutex('S');
+
+    uint16_t get(State::Field field)
     {
-        bool res = false;
+        uint16_t res = 0;
 
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_paramMutex.take())
         {
-            res = g_shutdownReq;
-            xSemaphoreGive(g_paramSemaphore);
+            res = g_image.values[static_cast<uint8_t>(field)];
+            g_paramMutex.give();
         }
 
         return res;
     }
 
-    void setShutdownRequest(bool req)
+    void set(State::Field field, uint16_t val)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
+        uint8_t idx = static_cast<uint8_t>(field);
+
+        if (g_paramMutex.take())
         {
-            g_shutdownReq = req;
-            xSemaphoreGive(g_paramSemaphore);
+            // SBC may have written newer value to server since last sync, MCU write must win anyway
+            if (g_image.values[idx] != val || field <= State::Field::BOOT_PHASE)
+            {
+                g_image.values[idx] = val;
+                g_image.dirty |= 1 << idx;
+            }
+            g_paramMutex.give();
         }
     }
+}
 
-    bool getShutdownFlag()
+namespace State
+{
+    void sync(Sync fn)
+    {
+        if (g_paramMutex.take())
+        {
+            fn(g_image);
+            g_image.dirty = 0;
+            g_paramMutex.give();
+        }
+    }
+
+    void setScene(const Scene &scene)
+    {
+        if (g_paramMutex.take())
+        {
+            g_scene = scene;
+            g_scenePending = true;
+            g_paramMutex.give();
+        }
+    }
+
+    bool takeScene(Scene &scene)
     {
         bool res = false;
 
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_paramMutex.take())
         {
-            res = g_shutdownFlag;
-            xSemaphoreGive(g_paramSemaphore);
+            if (g_scenePending)
+            {
+                scene = g_scene;
+                g_scenePending = false;
+                res = true;
+            }
+            g_paramMutex.give();
         }
 
         return res;
     }
 
-    void setShutdownFlag(bool flag)
+    void setFrame(const Frame &frame)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_paramMutex.take())
         {
-            g_shutdownFlag = flag;
-            xSemaphoreGive(g_paramSemaphore);
+            g_frame = frame;
+            g_framePending = true;
+            g_paramMutex.give();
         }
     }
 
-    bool getDisplayState()
+    bool takeFrame(Frame &frame)
     {
         bool res = false;
 
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
+        if (g_paramMutex.take())
         {
-            res = g_displayState;
-            xSemaphoreGive(g_paramSemaphore);
+            if (g_framePending)
+            {
+                frame = g_frame;
+                g_framePending = false;
+                res = true;
+            }
+            g_paramMutex.give();
         }
 
         return res;
     }
 
+    bool getShutdownRequest()
+    {
+        return get(Field::SHUTDOWN_REQ);
+    }
+
+    void setShutdownRequest(bool req)
+    {
+        set(Field::SHUTDOWN_REQ, req);
+    }
+
+    bool getShutdownFlag()
+    {
+        return get(Field::SHUTDOWN_FLAG);
+    }
+
+    void setShutdownFlag(bool flag)
+    {
+        set(Field::SHUTDOWN_FLAG, flag);
+    }
+
+    bool getDisplayState()
+    {
+        return get(Field::DISPLAY_STATE);
+    }
+
     void setDisplayState(bool state)
     {
-        state = true;
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_displayState = state;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        set(Field::DISPLAY_STATE, state);
     }
 
     bool getJoy1Enable()
     {
-        bool res;
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            res = g_joy1Enable;
-            xSemaphoreGive(g_paramSemaphore);
-        }
-        return res;
+        return get(Field::JOY1_ENABLE);
     }
 
     void setJoy1Enable(bool ena)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_joy1Enable = ena;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        set(Field::JOY1_ENABLE, ena);
     }
 
     bool getJoy2Enable()
     {
-        bool res;
-
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            res = g_joy2Enable;
-            xSemaphoreGive(g_paramSemaphore);
-        }
-
-        return res;
+        return get(Field::JOY2_ENABLE);
     }
 
     void setJoy2Enable(bool ena)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_joy2Enable = ena;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        set(Field::JOY2_ENABLE, ena);
     }
 
     uint8_t getJoy1Brightness()
     {
-        uint8_t res;
-
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            res = g_joy1Brightness;
-            xSemaphoreGive(g_paramSemaphore);
-        }
-
-        return res;
+        return get(Field::JOY1_BRIGHTNESS);
     }
 
     void setJoy1Brightness(uint8_t val)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_joy1Brightness = val;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        set(Field::JOY1_BRIGHTNESS, val);
     }
 
     uint8_t getJoy2Brightness()
     {
-        uint8_t res;
+        return get(Field::JOY2_BRIGHTNESS);
+    }
 
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            res = g_joy2Brightness;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+    void setJoy2Brightness(uint8_t val)
+    {
+        set(Field::JOY2_BRIGHTNESS, val);
+    }
 
-        return res;
+    uint16_t getSelectorValue()
+    {
+        return get(Field::SELECTOR_VALUE);
     }
 
-    void setJoy2Brightness(uint8_t val)
+    void setSelectorValue(uint16_t val)
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_joy2Brightness = val;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        set(Field::SELECTOR_VALUE, val);
     }
 
-    uint8_t getSelectorValue()
+    uint16_t getSelectorPreview()
     {
-        uint8_t res;
+        return get(Field::SELECTOR_PREVIEW);
+    }
 
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            res = g_selectorValue;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+    uint16_t getSelectorPreviewDwell()
+    {
+        return get(Field::SELECTOR_DWELL);
+    }
 
-        return res;
+    void setSelectorPreview(uint16_t val, uint16_t dwell)
+    {
+        set(Field::SELECTOR_PREVIEW, val);
+        set(Field::SELECTOR_DWELL, dwell);
     }
 
-    void setSelectorValue(uint8_t val)
+    uint16_t getSelectorMaxSlot()
     {
-        if (xSemaphoreTake(g_paramSemaphore, (TickType_t)5) == pdTRUE)
-        {
-            g_selectorValue = val;
-            xSemaphoreGive(g_paramSemaphore);
-        }
+        return get(Field::SELECTOR_MAX_SLOT);
+    }
+
+    void setSelectorMaxSlot(uint16_t val)
+    {
+        set(Field::SELECTOR_MAX_SLOT, val);
+    }
+
+    uint8_t getBootPhase()
+    {
+        return get(Field::BOOT_PHASE);
+    }
+
+    void setBootPhase(uint8_t phase)
+    {
+        set(Field::BOOT_PHASE, phase);
+    }
+
+    Mutex::Stats getMutexStats()
+    {
+        return g_paramMutex.stats();
     }
 }
\ No newline at end of file
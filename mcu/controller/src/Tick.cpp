@@ -0,0 +1,62 @@
+#ifndef COOP_EXECUTOR
+#include "Tick.hpp"
+
+#ifdef TIMER2_TICK
+#define TICK_STR(x) #x
+#define TICK_XSTR(x) TICK_STR(x)
+
+namespace Tick
+{
+    void init()
+    {
+        uint8_t sreg = SREG;
+        cli();
+
+        // Watchdog tick off, port handler is entered from Timer2 from now on
+        WDTCSR = (1 << WDCE) | (1 << WDE);
+        WDTCSR = 0;
+
+        TCCR2A = 1 << WGM21; // CTC, TOP is OCR2A
+        TCCR2B = TIMER_PRESCALER == 128 ? (1 << CS22) | (1 << CS20) : (1 << CS22) | (1 << CS21);
+        OCR2A = TIMER_COUNTS - 1;
+        TCNT2 = 0;
+        TIFR2 = 1 << OCF2A;
+        TIMSK2 |= 1 << OCIE2A;
+
+        SREG = sreg;
+    }
+
+    void suspend()
+    {
+        // Timer2 stops in power down by itself
+    }
+
+    void resume()
+    {
+    }
+}
+
+// Port handler saves context itself, so this vector must not touch any register
+ISR(TIMER2_COMPA_vect, ISR_NAKED)
+{
+    asm volatile("jmp " TICK_XSTR(WDT_vect));
+}
+#else
+namespace Tick
+{
+    void init()
+    {
+    }
+
+    void suspend()
+    {
+        WDTCSR &= ~(1 << WDIE);
+    }
+
+    void resume()
+    {
+        WDTCSR |= 1 << WDIE;
+    }
+}
+#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#include "Trace.hpp"
+
+#ifdef TRACE_ENABLED
+#include "Config.hpp"
+
+namespace
+{
+    constexpr uint8_t RING_SIZE = Config::Trace::RING_SIZE;
+    constexpr uint8_t CHUNK_HEADER_SIZE = 3; // Window registers before chunk bytes.
+    constexpr uint8_t CHUNK_SIZE = (Config::Communication::InputRegs::DIAG_WINDOW_SIZE - CHUNK_HEADER_SIZE) * 2;
+    constexpr uint8_t MAX_OBJECTS = 4;
+
+    static_assert(RING_SIZE <= 128, "Ring indexes are 8 bit");
+
+    uint8_t g_ring[RING_SIZE];
+    volatile uint8_t g_head = 0; // Written only by recorder.
+    volatile uint8_t g_tail = 0; // Written only by acknowledge().
+    uint16_t g_dropped = 0;
+
+    unsigned long g_lastStamp = 0;
+    uint8_t g_runningTask = 0;
+
+    void *g_objects[MAX_OBJECTS];
+    char g_objectNames[MAX_OBJECTS];
+
+    uint16_t g_chunkSeq = 0;
+    uint8_t g_chunkLen = 0;
+
+    uint8_t used()
+    {
+        return (uint8_t)(g_head + RING_SIZE - g_tail) % RING_SIZE;
+    }
+
+    void push(uint8_t b)
+    {
+        g_ring[g_head] = b;
+        g_head = (g_head + 1) % RING_SIZE;
+    }
+
+    void record(uint8_t type, uint8_t arg)
+    {
+        uint8_t sreg = SREG;
+        cli();
+
+        unsigned long now = micros();
+        unsigned long delta = (now - g_lastStamp) >> 4;
+
+        uint8_t len = 3;
+        for (unsigned long d = delta >> 7; d; d >>= 7)
+        {
+            len++;
+        }
+
+        if (RING_SIZE - 1 - used() < len)
+        {
+            g_dropped++;
+        }
+        else
+        {
+            // Advance by whole units only so rounding doesn't accumulate.
+            g_lastStamp += delta << 4;
+
+            push(type);
+            push(arg);
+            do
+            {
+                uint8_t b = delta & 0x7f;
+                delta >>= 7;
+                if (delta)
+                {
+                    b |= 0x80;
+                }
+                push(b);
+            } while (delta);
+        }
+
+        SREG = sreg;
+    }
+}
+
+extern "C"
+{
+    void traceSwitchedIn(uint8_t task)
+    {
+        // Called on every tick even if the same task keeps running.
+        if (task == g_runningTask)
+        {
+            return;
+        }
+        g_runningTask = task;
+        record(TRACE_EVT_SWITCH, task);
+    }
+
+    void traceTaskEvent(uint8_t type, uint8_t task)
+    {
+        record(type, task);
+    }
+
+    void traceObjectEvent(uint8_t type, void *object)
+    {
+        for (uint8_t i = 0; i < MAX_OBJECTS; i++)
+        {
+            if (g_objects[i] == object)
+            {
+                record(type, g_objectNames[i]);
+                return;
+            }
+        }
+    }
+}
+
+namespace Trace
+{
+    void nameObject(void *object, char name)
+    {
+        for (uint8_t i = 0; i < MAX_OBJECTS; i++)
+        {
+            if (!g_objects[i])
+            {
+                g_objectNames[i] = name;
+                g_objects[i] = object;
+                return;
+            }
+        }
+    }
+
+    void acknowledge(uint16_t seq)
+    {
+        if (seq != g_chunkSeq)
+        {
+            return;
+        }
+
+        g_tail = (g_tail + g_chunkLen) % RING_SIZE;
+        g_chunkSeq++;
+
+        // Freeze chunk length so SBC acknowledges exactly what it has read.
+        g_chunkLen = min(used(), CHUNK_SIZE);
+    }
+
+    void fill(Diag::Writer write)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t dropped = g_dropped;
+        SREG = sreg;
+
+        write(0, g_chunkSeq);
+        write(1, g_chunkLen);
+        write(2, dropped);
+
+        for (uint8_t i = 0; i < g_chunkLen; i += 2)
+        {
+            uint16_t val = g_ring[(g_tail + i) % RING_SIZE];
+            if (i + 1 < g_chunkLen)
+            {
+                val |= (uint16_t)g_ring[(g_tail + i + 1) % RING_SIZE] << 8;
+            }
+            write(CHUNK_HEADER_SIZE + i / 2, val);
+        }
+    }
+}
+#endif
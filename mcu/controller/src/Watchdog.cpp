@@ -0,0 +1,250 @@
+#include "Watchdog.hpp"
+#include <avr/wdt.h>
+#include "Config.hpp"
+
+#if defined(TIMER2_TICK) || defined(COOP_EXECUTOR)
+#define WATCHDOG_HARDWARE
+#endif
+
+namespace
+{
+    constexpr uint16_t MAGIC = 0x5EED;
+    constexpr uint8_t NO_TASK = 0xFE;
+
+    /**
+     * @brief State kept over reset in .noinit RAM, random after power on.
+     */
+    struct Record
+    {
+        uint16_t magic;
+        Watchdog::Outputs outputs;
+        uint8_t pendingTask; // Task that is being reset for, NO_TASK while running.
+        uint16_t overdue;
+        uint16_t faults;
+        uint8_t lastTask;
+        uint16_t lastOverdue;
+        uint8_t check;
+    };
+
+    Record g_record __attribute__((section(".noinit")));
+    uint8_t g_resetCause __attribute__((section(".noinit")));
+
+    // Indexed by Watchdog::Task
+    constexpr unsigned long DEADLINES[Watchdog::TASKS] = {Config::Watchdog::APP_DEADLINE, Config::Watchdog::DISP_DEADLINE};
+
+    unsigned long g_checkIns[Watchdog::TASKS]; // millis() of last check-in.
+    bool g_started = false;
+    Watchdog::Stats g_stats;
+}
+
+/**
+ * @brief Runs before any other startup code. Watchdog stays enabled after watchdog reset
+ * until WDRF is cleared, it would reset MCU again during startup.
+ */
+void saveResetCause() __attribute__((naked, used, section(".init3")));
+void saveResetCause()
+{
+    g_resetCause = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+namespace Watchdog
+{
+    bool init(Outputs &outputs);
+    void start();
+    void checkIn(Task task);
+    void setOutputs(const Outputs &outputs);
+    void supervise();
+    void tick();
+    void suspend();
+    void resume();
+    Stats stats();
+
+    /**
+     * @brief Record missed deadline and reset MCU.
+     */
+    void fault(uint8_t task, unsigned long overdue) __attribute__((noreturn));
+
+    /**
+     * @brief Reset MCU if any task missed its deadline.
+     */
+    void checkDeadlines();
+
+    /**
+     * @brief Update check of record, call with interrupts disabled.
+     */
+    void seal();
+    uint8_t check(const Record &record);
+
+    bool init(Outputs &outputs)
+    {
+        g_stats.resetCause = g_resetCause;
+
+        bool warm = !(g_resetCause & (1 << PORF)) && g_record.magic == MAGIC && g_record.check == check(g_record);
+        if (!warm)
+        {
+            g_record.magic = MAGIC;
+            g_record.outputs = Outputs();
+            g_record.pendingTask = NO_TASK;
+            g_record.faults = 0;
+            g_record.lastTask = 0;
+            g_record.lastOverdue = 0;
+            seal();
+
+            return false;
+        }
+
+        // Bootloader may have cleared reset cause, unknown cause is counted as watchdog timeout
+        if (g_record.pendingTask != NO_TASK || g_resetCause == 0 || (g_resetCause & (1 << WDRF)))
+        {
+            bool recorded = g_record.pendingTask != NO_TASK;
+            g_record.faults++;
+            g_record.lastTask = recorded ? g_record.pendingTask : static_cast<uint8_t>(Task::HARDWARE);
+            g_record.lastOverdue = recorded ? g_record.overdue : 0;
+        }
+        g_record.pendingTask = NO_TASK;
+        seal();
+
+        g_stats.faults = g_record.faults;
+        g_stats.lastTask = g_record.lastTask;
+        g_stats.lastOverdue = g_record.lastOverdue;
+        g_stats.warm = true;
+
+        outputs = g_record.outputs;
+        return true;
+    }
+
+    void start()
+    {
+        unsigned long now = millis();
+        for (uint8_t i = 0; i < TASKS; i++)
+        {
+            g_checkIns[i] = now;
+        }
+        g_started = true;
+
+#ifdef WATCHDOG_HARDWARE
+        wdt_enable(WDTO_1S);
+#endif
+    }
+
+    void checkIn(Task task)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        g_checkIns[static_cast<uint8_t>(task)] = millis();
+        SREG = sreg;
+    }
+
+    void setOutputs(const Outputs &outputs)
+    {
+        uint8_t sreg = SREG;
+        cli();
+        g_record.outputs = outputs;
+        seal();
+        SREG = sreg;
+    }
+
+    void supervise()
+    {
+        if (!g_started)
+        {
+            return;
+        }
+
+        checkDeadlines();
+
+#ifdef WATCHDOG_HARDWARE
+        wdt_reset();
+#endif
+    }
+
+    void tick()
+    {
+#ifndef WATCHDOG_HARDWARE
+        // Tick interrupt runs even while a busy task starves loop()
+        if (g_started)
+        {
+            checkDeadlines();
+        }
+#endif
+    }
+
+    void checkDeadlines()
+    {
+        unsigned long now = millis();
+
+        for (uint8_t i = 0; i < TASKS; i++)
+        {
+            // Task may check in in the middle of 32 bit read
+            uint8_t sreg = SREG;
+            cli();
+            unsigned long elapsed = now - g_checkIns[i];
+            SREG = sreg;
+
+            // Check-in after now was sampled is in the past
+            if ((long)elapsed > (long)DEADLINES[i])
+            {
+                fault(i, elapsed - DEADLINES[i]);
+            }
+        }
+    }
+
+    void suspend()
+    {
+#ifdef WATCHDOG_HARDWARE
+        if (g_started)
+        {
+            wdt_disable();
+        }
+#endif
+    }
+
+    void resume()
+    {
+#ifdef WATCHDOG_HARDWARE
+        if (g_started)
+        {
+            wdt_enable(WDTO_1S);
+        }
+#endif
+    }
+
+    Stats stats()
+    {
+        return g_stats;
+    }
+
+    void fault(uint8_t task, unsigned long overdue)
+    {
+        cli();
+        g_record.pendingTask = task;
+        g_record.overdue = min(overdue, 0xFFFFUL);
+        seal();
+
+        // Also takes over WDT used as FreeRTOS tick, nothing runs from now on anyway
+        wdt_enable(WDTO_15MS);
+        while (true)
+        {
+        }
+    }
+
+    void seal()
+    {
+        g_record.check = check(g_record);
+    }
+
+    uint8_t check(const Record &record)
+    {
+        uint8_t res = 0xA5; // Zeroed RAM doesn't pass the check.
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+
+        for (uint8_t i = 0; i < offsetof(Record, check); i++)
+        {
+            res = (res << 1 | res >> 7) ^ bytes[i];
+        }
+
+        return res;
+    }
+}
\ No newline at end of file
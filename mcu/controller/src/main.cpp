@@ -2,11 +2,16 @@
 #if LOG_LEVEL != NONE
 #include <SoftwareSerial.h>
 #endif
+#ifndef COOP_EXECUTOR
 #include <Arduino_FreeRTOS.h>
+#endif
+#include "Executor.hpp"
 #include "Log.hpp"
 #include "AppTask.hpp"
 #include "DisplayTask.hpp"
 #include "Config.hpp"
+#include "Power.hpp"
+#include "Watchdog.hpp"
 
 namespace
 {
@@ -14,8 +19,19 @@ namespace
   SoftwareSerial g_logSerial(Config::Main::GPIO::LOG_SERIAL_RX, Config::Main::GPIO::LOG_SERIAL_TX);
 #endif
 
+#ifndef COOP_EXECUTOR
+  StackType_t g_appStack[App::getRequiredStack()];
+  StaticTask_t g_appTcb;
+
+  StackType_t g_dispStack[Disp::getRequiredStack()];
+  StaticTask_t g_dispTcb;
+#endif
 }
 
+#if !defined(COOP_EXECUTOR) && configUSE_TICK_HOOK != 1
+#error "Watchdog checks deadlines from tick hook, set configUSE_TICK_HOOK to 1"
+#endif
+
 void setup()
 {
 #if LOG_LEVEL != NONE
@@ -23,17 +39,41 @@ void setup()
   logger::init(g_logSerial);
 #endif
 
-  xTaskCreate(
+#ifndef COOP_EXECUTOR
+  // Same order as executor jobs, so RUNTIME diag page reports their stacks in place
+  Executor::addTask(xTaskCreateStatic(
       App::task, "app",
       App::getRequiredStack(), NULL,
-      1, NULL);
+      1, g_appStack, &g_appTcb));
 
-  xTaskCreate(
+  Executor::addTask(xTaskCreateStatic(
       Disp::task, "disp",
       Disp::getRequiredStack(), NULL,
-      0, NULL);
+      0, g_dispStack, &g_dispTcb));
+#else
+  App::init();
+  Disp::init();
+
+  // App first, it has priority in FreeRTOS build too
+  Executor::add(App::step, Config::AppTask::LOOP_PERIOD);
+  Executor::add(Disp::step, Config::DisplayTask::LOOP_DELAY);
+#endif
 }
 
+// FreeRTOS calls this from idle task hook
 void loop()
 {
-}
\ No newline at end of file
+#ifdef COOP_EXECUTOR
+  Executor::run();
+#endif
+  Watchdog::supervise();
+  Power::idle();
+}
+
+#ifndef COOP_EXECUTOR
+// FreeRTOS calls this from tick interrupt
+extern "C" void vApplicationTickHook()
+{
+  Watchdog::tick();
+}
+#endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 """MODBUS instrument for Cady shield"""
 import logging
+from time import sleep
 from threading import Lock
 import minimalmodbus
 import serial
@@ -10,6 +11,41 @@ logger = logging.getLogger(__name__)
 class MCUInstrument:
     """MODBUS instrument for Cady shield"""
 
+    DIAG_PAGE_MUTEX_STATE: int = 1
+    DIAG_PAGE_MUTEX_LOG: int = 2
+    DIAG_PAGE_MUTEX_DISP: int = 3
+    DIAG_PAGE_TRACE: int = 4
+    DIAG_PAGE_RUNTIME: int = 5
+    DIAG_PAGE_POWER: int = 6
+    DIAG_PAGE_BOOT: int = 7
+    DIAG_PAGE_WATCHDOG: int = 8
+    DIAG_PAGE_APP_STATES: int = 9
+    DIAG_PAGE_CADENCE: int = 10
+
+    # Boot phases reported to MCU, it learns from their timing how long boot may take
+    BOOT_PHASE_DAEMON: int = 1
+    BOOT_PHASE_FRONTEND: int = 2
+
+    # LED effect codes for scenes and profiles
+    LED_EFFECTS: dict = {"manual": 0, "off": 1, "blinking": 2,
+                         "alternating_blinking": 4, "fast_blinking": 5, "stream": 6}
+
+    # Slots 0..PROFILE_SLOTS-1 can have a profile, matches Config::Profiles::COUNT
+    PROFILE_SLOTS: int = 64
+
+    # MCU runtime settings in register order, zero selects compiled default
+    SETTINGS: tuple = ("boot_timeout_s", "shutdown_duration_s", "sbc_hb_check_period_ms", "sbc_hb_max_retries",
+                       "serial_baud_100", "blinking_ratio_permille", "fast_blinking_ratio_permille",
+                       "display_disable_check_ms", "display_transition_delay_ms", "display_click_ms",
+                       "click_timeout_ms", "resume_mode", "wake_on_select")
+
+    # Values of resume_mode and wake_on_select settings
+    RESUME_MODE_OFF: int = 1  # Wait for power button after MCU start
+    RESUME_MODE_LAST: int = 2  # Boot if SBC was on when MCU lost power
+    RESUME_MODE_ALWAYS: int = 3
+    WAKE_ON_SELECT_OFF: int = 1
+    WAKE_ON_SELECT_ON: int = 2
+
     __Q_SHUTDOWN_FLAG_ADDR: int = 0
     __Q_DISPLAY_STATE_ADDR: int = 1
     __Q_JOY1_ENA_FLAG_ADDR: int = 2
@@ -20,9 +56,36 @@ class MCUInstrument:
     __AQ_SBC_HB_CNTR_ADDR: int = 0
     __AQ_JOY1_LED_BRIGHTNESS_ADDR: int = 1
     __AQ_JOY2_LED_BRIGHTNESS_ADDR: int = 2
+    __AQ_DIAG_PAGE_ADDR: int = 3
+    __AQ_TRACE_ACK_ADDR: int = 4
+    __AQ_GAMESEL_MAX_ADDR: int = 5
+    __AQ_SCENE_FLAGS_ADDR: int = 6
+    __AQ_SCENE_SEQ_ADDR: int = 9
+    __AQ_PROFILE_FIRST_SLOT_ADDR: int = 10
+    __PROFILE_BLOCK_SIZE: int = 4
+    __AQ_PROFILE_SEQ_ADDR: int = 20
+    __PROFILE_ERASE_FLAG: int = 0x8000
+    __AQ_SETTINGS_DATA_ADDR: int = 21
+    __AQ_SETTINGS_SEQ_ADDR: int = 34
+    __AQ_BOOT_PHASE_ADDR: int = 35
+    __AQ_STREAM_INTERVAL_ADDR: int = 36
+    __AQ_STREAM_FRAME_ADDR: int = 37
+    __STREAM_FRAME_SIZE: int = 2
+    __STREAM_FRAMES: int = 2
 
     __AI_MCU_HB_CNTR_ADDR: int = 0
     __AI_MCU_GAMESEL_ADDR: int = 1
+    __AI_DIAG_PAGE_ADDR: int = 2
+    __AI_DIAG_WINDOW_ADDR: int = 3
+    __DIAG_WINDOW_SIZE: int = 12
+    __AI_GAMESEL_PREVIEW_ADDR: int = 15
+    __AI_GAMESEL_DWELL_ADDR: int = 16
+    __AI_SCENE_DONE_SEQ_ADDR: int = 17
+    __AI_PROFILE_DONE_SEQ_ADDR: int = 18
+    __AI_SETTINGS_DONE_SEQ_ADDR: int = 19
+    __AI_SETTINGS_STORED_ADDR: int = 20
+    __AI_STREAM_SEQ_ADDR: int = 21
+    __DIAG_PAGE_RETRIES: int = 10
 
     __READ_COIL: int = 1
     __READ_INPUT: int = 2
@@ -30,12 +93,17 @@ class MCUInstrument:
     __READ_INPUT_REGISTER: int = 4
     __FORCE_SINGLE_COIL: int = 5
     __PRESET_SINGLE_REGISTER: int = 6
+    __PRESET_MULTIPLE_REGISTERS: int = 16
 
     __client: minimalmodbus.Instrument
     __instrument_mtx: Lock
 
     __sbc_heartbeat_cntr: int = 0
     __mcu_heartbeat_cntr: int = 0
+    __scene_seq: int = -1  # Continued from MCU on first use
+    __profile_seq: int = -1  # Continued from MCU on first use
+    __settings_seq: int = -1  # Continued from MCU on first use
+    __stream_seq: int = 0
 
     def __init__(self, port: str, timeout: int, slave_addr: int) -> None:
         self.__instrument_mtx = Lock()
@@ -149,6 +217,208 @@ class MCUInstrument:
 
         self.__write_register(self.__AQ_JOY2_LED_BRIGHTNESS_ADDR, val)
 
+    def set_gamesel_max_slot(self, val: int) -> bool:
+        """Set highest slot selectable on MCU, 0 restores MCU default"""
+        if val > 0xFFFF:
+            val = 0xFFFF
+        elif val < 0:
+            val = 0
+
+        return self.__write_register(self.__AQ_GAMESEL_MAX_ADDR, val)
+
+    def set_boot_phase(self, phase: int) -> bool:
+        """Report BOOT_PHASE_* reached by SBC, MCU ignores phases older than the current one"""
+        return self.__write_register(self.__AQ_BOOT_PHASE_ADDR, phase)
+
+    def apply_scene(self, display: bool, joy1: bool, joy2: bool, joy1_brightness: int = 0,
+                    joy2_brightness: int = 0, effect: int = 0, step_delay_ms: int = 0,
+                    display_last: bool = False) -> int:
+        """Let MCU switch display, joys and LEDs as one transition
+
+        Display is switched first, other outputs step_delay_ms later (reversed if display_last).
+        Effect 0 keeps manual brightness, otherwise LED effect index + 1.
+        Returns sequence number to pass to wait_scene(), -1 on error.
+        """
+        joy1_brightness = max(0, min(255, joy1_brightness))
+        joy2_brightness = max(0, min(255, joy2_brightness))
+        step_delay_ms = max(0, min(0xFFFF, step_delay_ms))
+
+        flags = (display << 0) | (joy1 << 1) | (joy2 << 2) | (display_last << 3) | ((effect & 0x0F) << 8)
+
+        with self.__instrument_mtx:
+            try:
+                self.__scene_seq = self.__next_seq(self.__AQ_SCENE_SEQ_ADDR, self.__scene_seq)
+                self.__client.write_registers(
+                    self.__AQ_SCENE_FLAGS_ADDR,
+                    [flags, joy1_brightness | (joy2_brightness << 8), step_delay_ms, self.__scene_seq])
+                return self.__scene_seq
+
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return -1
+
+    def start_stream(self, interval_ms: int) -> bool:
+        """Tell MCU how often stream frames come, 0 disables late frame counting.
+        Select "stream" LED effect by scene or profile to show the frames."""
+        return self.__write_register(self.__AQ_STREAM_INTERVAL_ADDR, max(0, min(0xFFFF, interval_ms)))
+
+    def send_frame(self, joy1_brightness: int, joy2_brightness: int) -> int:
+        """Stream LED frame, MCU shows it from next PWM period. Returns its sequence number, -1 on error"""
+        joy1_brightness = max(0, min(255, joy1_brightness))
+        joy2_brightness = max(0, min(255, joy2_brightness))
+
+        with self.__instrument_mtx:
+            # Zero is MCU initial value, never use it
+            self.__stream_seq = self.__stream_seq % 0xFFFF + 1
+            # Alternate buffers so MCU still finds previous frame if it falls behind
+            addr = self.__AQ_STREAM_FRAME_ADDR + (self.__stream_seq % self.__STREAM_FRAMES) * self.__STREAM_FRAME_SIZE
+            try:
+                self.__client.write_registers(addr, [joy1_brightness | (joy2_brightness << 8), self.__stream_seq])
+                return self.__stream_seq
+
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return -1
+
+    def get_stream_stats(self) -> dict:
+        """Get sequence number of last frame MCU took, frames it never showed and frames that came late"""
+        with self.__instrument_mtx:
+            try:
+                seq, dropped, late = self.__client.read_registers(
+                    self.__AI_STREAM_SEQ_ADDR, 3, functioncode=self.__READ_INPUT_REGISTER)
+                return {"seq": seq, "dropped": dropped, "late": late}
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return {}
+
+    def __read_input_register(self, addr: int) -> int:
+        with self.__instrument_mtx:
+            try:
+                return self.__client.read_register(
+                    addr, functioncode=self.__READ_INPUT_REGISTER)
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return -1
+
+    def __next_seq(self, addr: int, seq: int) -> int:
+        """Sequence number following seq. MCU acts on a change of holding register at addr, so the first one
+        continues from its value and a restarted daemon doesn't repeat the number MCU saw last.
+        Call with instrument mutex held."""
+        if seq < 0:
+            seq = self.__client.read_register(addr, functioncode=self.__READ_HOLDING_REGISTER)
+
+        # Zero is MCU initial value, never use it
+        return seq % 0xFFFF + 1
+
+    def __wait_seq(self, addr: int, seq: int, timeout: float, poll_period: float = 0.1) -> bool:
+        """Wait until input register at addr reports given sequence number"""
+        if seq < 0:
+            return False
+
+        while timeout > 0:
+            if self.__read_input_register(addr) == seq:
+                return True
+            sleep(poll_period)
+            timeout -= poll_period
+
+        return False
+
+    def get_scene_done(self) -> int:
+        """Get sequence number of last scene MCU fully applied, -1 on error"""
+        return self.__read_input_register(self.__AI_SCENE_DONE_SEQ_ADDR)
+
+    def wait_scene(self, seq: int, timeout: float, poll_period: float = 0.1) -> bool:
+        """Wait until MCU applied scene with given sequence number"""
+        return self.__wait_seq(self.__AI_SCENE_DONE_SEQ_ADDR, seq, timeout, poll_period)
+
+    def upload_profiles(self, profiles: dict, num_slots: int, timeout: float = 2) -> bool:
+        """Store per-slot output profiles in MCU EEPROM, MCU applies them as soon as slot is selected
+
+        profiles maps slot to (joy1, joy2, joy1_brightness, joy2_brightness, effect),
+        slots below num_slots without profile are erased. MCU keeps PROFILE_SLOTS slots at most.
+        """
+        num_slots = min(num_slots, self.PROFILE_SLOTS)
+        for first in range(0, num_slots, self.__PROFILE_BLOCK_SIZE):
+            slots = range(first, min(first + self.__PROFILE_BLOCK_SIZE, num_slots))
+
+            data = []
+            for slot in slots:
+                if slot in profiles:
+                    joy1, joy2, joy1_brightness, joy2_brightness, effect = profiles[slot]
+                    data.append((joy1 << 1) | (joy2 << 2) | ((effect & 0x0F) << 8))
+                    data.append(max(0, min(255, joy1_brightness)) | (max(0, min(255, joy2_brightness)) << 8))
+                else:
+                    data.extend([self.__PROFILE_ERASE_FLAG, 0])
+            data.extend([0] * (2 * self.__PROFILE_BLOCK_SIZE - len(data)))
+
+            with self.__instrument_mtx:
+                try:
+                    self.__profile_seq = self.__next_seq(self.__AQ_PROFILE_SEQ_ADDR, self.__profile_seq)
+                    seq = self.__profile_seq
+                    self.__client.write_registers(
+                        self.__AQ_PROFILE_FIRST_SLOT_ADDR, [first, len(slots)] + data + [seq])
+
+                except serial.SerialException as e:
+                    logger.error(e.strerror)
+                    return False
+
+            # MCU has single block buffer, wait until it's stored
+            if not self.__wait_seq(self.__AI_PROFILE_DONE_SEQ_ADDR, seq, timeout):
+                logger.error("MCU didn't store profiles %d..%d", first, slots[-1])
+                return False
+
+        return True
+
+    def get_settings(self) -> dict:
+        """Get active MCU runtime settings by SETTINGS name, "stored" tells whether they come from EEPROM"""
+        with self.__instrument_mtx:
+            try:
+                values = self.__client.read_registers(
+                    self.__AQ_SETTINGS_DATA_ADDR, len(self.SETTINGS), functioncode=self.__READ_HOLDING_REGISTER)
+                stored = self.__client.read_register(
+                    self.__AI_SETTINGS_STORED_ADDR, functioncode=self.__READ_INPUT_REGISTER)
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return {}
+
+        settings = dict(zip(self.SETTINGS, values))
+        settings["stored"] = bool(stored)
+        return settings
+
+    def set_settings(self, settings: dict, timeout: float = 2) -> bool:
+        """Store given MCU runtime settings to EEPROM, others keep their active values
+
+        MCU replaces out of range values by compiled defaults, check get_settings() for what is active.
+        Serial baud must be a standard rate (1200..115200), it is applied after MCU reset.
+        Holding power button while MCU starts falls back to compiled baud until next reset.
+        """
+        unknown = set(settings) - set(self.SETTINGS)
+        if unknown:
+            logger.error("Unknown MCU settings: %s", ", ".join(sorted(unknown)))
+            return False
+
+        active = self.get_settings()
+        if not active:
+            return False
+
+        values = [max(0, min(0xFFFF, int(settings.get(name, active[name])))) for name in self.SETTINGS]
+
+        with self.__instrument_mtx:
+            try:
+                self.__settings_seq = self.__next_seq(self.__AQ_SETTINGS_SEQ_ADDR, self.__settings_seq)
+                seq = self.__settings_seq
+                self.__client.write_registers(self.__AQ_SETTINGS_DATA_ADDR, values + [seq])
+
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return False
+
+        if not self.__wait_seq(self.__AI_SETTINGS_DONE_SEQ_ADDR, seq, timeout):
+            logger.error("MCU didn't store settings")
+            return False
+
+        return True
+
     def get_gamesel_value(self) -> int:
         """Get game selector value, returns -1 on error, otherwise a valid gamesel value"""
         with self.__instrument_mtx:
@@ -158,3 +428,139 @@ class MCUInstrument:
             except serial.SerialException as e:
                 logger.error(e.strerror)
                 return -1
+
+    def get_gamesel_preview(self) -> tuple:
+        """Get (value, dwell ms) of game selector value not applied yet, (-1, 0) on error"""
+        with self.__instrument_mtx:
+            try:
+                value, dwell = self.__client.read_registers(
+                    self.__AI_GAMESEL_PREVIEW_ADDR, 2, functioncode=self.__READ_INPUT_REGISTER)
+                return value, dwell
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return -1, 0
+
+    def read_diag_page(self, page: int) -> list:
+        """Read diag window with given page exposed, returns empty list on error"""
+        with self.__instrument_mtx:
+            try:
+                self.__client.write_register(
+                    self.__AQ_DIAG_PAGE_ADDR, page, functioncode=self.__PRESET_SINGLE_REGISTER)
+
+                # MCU switches page on its next loop iteration
+                for _ in range(self.__DIAG_PAGE_RETRIES):
+                    if self.__client.read_register(
+                            self.__AI_DIAG_PAGE_ADDR, functioncode=self.__READ_INPUT_REGISTER) == page:
+                        return self.__client.read_registers(
+                            self.__AI_DIAG_WINDOW_ADDR, self.__DIAG_WINDOW_SIZE,
+                            functioncode=self.__READ_INPUT_REGISTER)
+                    sleep(0.05)
+
+                logger.error("Diag page %d not exposed by MCU", page)
+                return []
+
+            except serial.SerialException as e:
+                logger.error(e.strerror)
+                return []
+
+    def get_mutex_stats(self, page: int) -> dict:
+        """Get counters of MCU mutex exposed on given DIAG_PAGE_MUTEX_* page"""
+        window = self.read_diag_page(page)
+        if not window:
+            return {}
+
+        return {"acquisitions": window[0], "contended": window[1],
+                "wait_ticks": window[2], "timeouts": window[3]}
+
+    def get_runtime_stats(self) -> dict:
+        """Get free RAM and timing of executor jobs (app, disp) since boot
+
+        FreeRTOS build reports free heap and free stack of tasks instead, their timing is zero.
+        """
+        window = self.read_diag_page(self.DIAG_PAGE_RUNTIME)
+        if not window:
+            return {}
+
+        jobs = {}
+        for i, name in enumerate(("app", "disp")):
+            jobs[name] = {"runs": window[1 + 4 * i], "max_lateness_ms": window[2 + 4 * i],
+                          "max_duration_us": window[3 + 4 * i], "free_stack": window[4 + 4 * i]}
+
+        return {"free_ram": window[0], "jobs": jobs}
+
+    def get_power_stats(self) -> dict:
+        """Get number of MCU power down sleeps and wake to handled latency in us"""
+        window = self.read_diag_page(self.DIAG_PAGE_POWER)
+        if not window:
+            return {}
+
+        return {"sleeps": window[0], "last_latency_us": window[1], "max_latency_us": window[2]}
+
+    def get_boot_stats(self) -> dict:
+        """Get current boot phase, boots in MCU history, learned deadline timeouts and per phase
+        time reached in last boot and learned deadline, both in seconds since SBC power on (0 if unknown).
+        Last shutdown time (s) and number of power cuts after detected halt (early) or full wait (late) too,
+        and how many of the timeouts were frontends that missed their deadline after daemon was up."""
+        window = self.read_diag_page(self.DIAG_PAGE_BOOT)
+        if not window:
+            return {}
+
+        phases = {}
+        for i, name in enumerate(("daemon", "frontend")):
+            phases[name] = {"last_s": window[3 + 2 * i] / 10, "deadline_s": window[4 + 2 * i] / 10}
+
+        return {"phase": window[0], "records": window[1], "timeouts": window[2], "phases": phases,
+                "shutdown_s": window[7] / 10, "early_cuts": window[8], "late_cuts": window[9],
+                "late_frontends": window[10]}
+
+    def get_watchdog_stats(self) -> dict:
+        """Get MCU watchdog resets since power on, task of last one ("app", "disp" or "hardware"),
+        how late it was (ms), MCU reset cause register and whether outputs survived last reset"""
+        window = self.read_diag_page(self.DIAG_PAGE_WATCHDOG)
+        if not window:
+            return {}
+
+        tasks = {0: "app", 1: "disp", 0xFF: "hardware"}
+        return {"faults": window[0], "last_task": tasks.get(window[1], str(window[1])),
+                "last_overdue_ms": window[2], "reset_cause": window[3], "warm": bool(window[4])}
+
+    def get_app_state_stats(self) -> dict:
+        """Get MCU state machine entries and last dwell (s) of each state since power on,
+        last and max transition latency (us)"""
+        window = self.read_diag_page(self.DIAG_PAGE_APP_STATES)
+        if not window:
+            return {}
+
+        states = ("off", "booting", "connected", "shutting_down", "error")
+        res = {name: {"entries": window[2 * i], "last_dwell_s": window[2 * i + 1]} for i, name in enumerate(states)}
+        res["last_latency_us"] = window[10]
+        res["max_latency_us"] = window[11]
+        return res
+
+    def get_cadence_stats(self) -> dict:
+        """Get current MCU app loop period (ms), its mode and seconds spent in each mode since boot"""
+        window = self.read_diag_page(self.DIAG_PAGE_CADENCE)
+        if not window:
+            return {}
+
+        modes = ("fast", "animation", "normal", "idle")
+        return {"period_ms": window[0], "mode": modes[window[1]] if window[1] < len(modes) else str(window[1]),
+                "seconds": {name: window[2 + i] for i, name in enumerate(modes)}}
+
+    def read_trace_chunk(self) -> tuple:
+        """Get (sequence number, chunk bytes, dropped events) of MCU trace, None on error"""
+        window = self.read_diag_page(self.DIAG_PAGE_TRACE)
+        if not window:
+            return None
+
+        seq, length, dropped = window[0], window[1], window[2]
+        data = bytearray()
+        for reg in window[3:]:
+            data.append(reg & 0xFF)
+            data.append(reg >> 8)
+
+        return seq, bytes(data[:length]), dropped
+
+    def ack_trace_chunk(self, seq: int) -> bool:
+        """Let MCU release trace chunk with given sequence number"""
+        return self.__write_register(self.__AQ_TRACE_ACK_ADDR, seq)
@@ -13,6 +13,9 @@ logger = logging.getLogger(__name__)
 class Daemon:
     """Daemon for supporting MCU communication"""
     __MCU_MAX_RETRIES: int = 30
+    __PREFETCH_DWELL_MS: int = 500  # How long player has to hover on slot to prefetch it
+    __TEARDOWN_DELAY_MS: int = 2000  # Joys stay on this long after display goes dark
+    __SCENE_TIMEOUT: float = 4  # How long to wait for MCU to confirm scene (s)
 
     __stop_evt: Event
     __mcu_err_evt: Event
@@ -22,13 +25,17 @@ class Daemon:
 
     __instrument: MCUInstrument
     __game_sel = -1
+    __prefetched = -1
     __process = None
+    __frontend_up = False  # First game was loaded, boot phase reported
+    __profiles: dict  # Slot profiles uploaded to MCU
 
     def __init__(self) -> None:
         self.__stop_evt = Event()
         self.__mcu_err_evt = Event()
         self.__heartbeat_thread = Thread(target=self.__heartbeat_task)
         self.__process_mtx = Lock()
+        self.__profiles = {}
 
     def start(self, instrument_port: str, instrument_timeout: int, instrument_addr: int) -> None:
         """Start the daemon"""
@@ -64,7 +71,9 @@ class Daemon:
 
         sleep(3)  # Wait for serial to open
 
-        self.__enable_joys(0)
+        self.__instrument.set_boot_phase(MCUInstrument.BOOT_PHASE_DAEMON)
+        self.__instrument.apply_scene(False, False, False)
+        self.__configure_slots()
 
         while not self.__stop_evt.is_set() and not self.__mcu_err_evt.is_set():
             sleep(1)
@@ -83,6 +92,16 @@ class Daemon:
                 logger.info("Game slot changed to %d", game_sel)
                 self.__game_sel = self.__load_game(game_sel)
 
+                if self.__game_sel >= 0 and not self.__frontend_up:
+                    self.__frontend_up = True
+                    self.__instrument.set_boot_phase(MCUInstrument.BOOT_PHASE_FRONTEND)
+                    logger.info("Boot stats: %s", str(self.__instrument.get_boot_stats()))
+
+            preview, dwell = self.__instrument.get_gamesel_preview()
+            if preview >= 0 and preview not in (self.__game_sel, self.__prefetched) \
+                    and dwell >= self.__PREFETCH_DWELL_MS:
+                self.__prefetch(preview)
+
     def __heartbeat_task(self) -> None:
         mcu_retries = 0
 
@@ -109,12 +128,114 @@ class Daemon:
                 self.__process.kill()
                 self.__process = None
 
-    def __load_game(self, slot: int) -> int:
-        self.__instrument.set_display_state(False)
+    def __configure_slots(self) -> None:
+        """Let MCU selector cover all slots from slots.yaml"""
+        try:
+            with open("slots.yaml", "r", encoding="utf8") as f:
+                config = yaml.safe_load(f)
+
+        except FileNotFoundError as e:
+            logger.error("slots.yaml not found: %s", str(e))
+            return
+
+        except yaml.YAMLError as e:
+            logger.error("slots.yaml is invalid: %s", str(e))
+            return
+
+        # Empty file loads as None
+        if not isinstance(config, dict):
+            logger.error("slots.yaml has no slot mapping")
+            return
+
+        slots = [int(key[len("slot"):]) for key in config
+                 if isinstance(key, str) and key.startswith("slot") and key[len("slot"):].isdigit()]
+        if not slots:
+            logger.error("No slots in slots.yaml")
+            return
+
+        logger.info("Highest slot: %d", max(slots))
+        self.__instrument.set_gamesel_max_slot(max(slots))
+
+        self.__profiles = {}
+        for slot in slots:
+            profile = self.__slot_profile(config["slot" + str(slot)])
+            if profile and slot >= MCUInstrument.PROFILE_SLOTS:
+                logger.warning("MCU has no profile slot %d, profile ignored", slot)
+            elif profile:
+                self.__profiles[slot] = profile
+
+        if self.__instrument.upload_profiles(self.__profiles,
+                                             min(max(slots) + 1, MCUInstrument.PROFILE_SLOTS)):
+            logger.info("Uploaded %d slot profiles", len(self.__profiles))
+
+        self.__configure_mcu(config.get("mcu_settings"))
+
+    def __configure_mcu(self, settings: dict) -> None:
+        """Store optional mcu_settings from slots.yaml in MCU unless it already uses them"""
+        if not settings:
+            return
+
+        if not isinstance(settings, dict):
+            logger.error("mcu_settings in slots.yaml must map setting names to values")
+            return
+
+        active = self.__instrument.get_settings()
+        if not active:
+            return
+
+        if all(active.get(name) == value for name, value in settings.items()):
+            return
+
+        if self.__instrument.set_settings(settings):
+            logger.info("Stored MCU settings: %s", str(self.__instrument.get_settings()))
+
+    def __slot_profile(self, slot_config: dict) -> tuple:
+        """Get (joy1, joy2, joy1_brightness, joy2_brightness, effect) of slot, None if config is invalid"""
+        try:
+            num_players = int(slot_config["players"])
+            effect = MCUInstrument.LED_EFFECTS[slot_config.get("led_effect", "manual")]
+
+            return (num_players > 0, num_players > 1,
+                    int(slot_config["joy1_brightness"]) if num_players > 0 else 0,
+                    int(slot_config["joy2_brightness"]) if num_players > 1 else 0,
+                    effect)
+
+        except Exception as e:
+            logger.error("Invalid slot config: %s", str(e))
+            return None
 
-        sleep(2)
+    def __prefetch(self, slot: int) -> None:
+        """Run optional prefetch_script of slot player hovers on, so loading it is faster"""
+        self.__prefetched = slot
 
-        self.__enable_joys(0)
+        try:
+            with open("slots.yaml", "r", encoding="utf8") as f:
+                config = yaml.safe_load(f)
+
+            script = config["slot" + str(slot)].get("prefetch_script")
+
+        except Exception as e:
+            logger.error("Processing yaml file failed: %s", str(e))
+            return
+
+        if not script:
+            return
+
+        logger.info("Prefetching slot %d", slot)
+        try:
+            subprocess.Popen(script, shell=True)
+        except Exception as e:
+            logger.error("Failed to prefetch slot %d: %s", slot, str(e))
+
+    def __load_game(self, slot: int) -> int:
+        # Display off first, joys and LEDs off once the screen is dark.
+        # Slots with profile keep outputs MCU already set up from it.
+        joy1, joy2, joy1_brightness, joy2_brightness, effect = \
+            self.__profiles.get(slot, (False, False, 0, 0, 0))
+        seq = self.__instrument.apply_scene(False, joy1, joy2, joy1_brightness, joy2_brightness, effect,
+                                            step_delay_ms=self.__TEARDOWN_DELAY_MS)
+        if not self.__instrument.wait_scene(seq, self.__SCENE_TIMEOUT):
+            logger.warning("MCU didn't confirm teardown scene")
 
         # Unload previous slot
         self.__kill_process()
@@ -135,21 +256,14 @@ class Daemon:
             self.__game_sel = -1
             return -1
 
-        num_players = 0
-        joy1_brightness = 0
-        joy2_brightness = 0
         settle_time = 0.1
 
         # Use selected slot
         slot_str = "slot" + str(slot)
         try:
             name = str(config[slot_str]["name"])
-            num_players = int(config[slot_str]["players"])
             open_script = str(config[slot_str]["open_script"])
 
-            joy1_brightness = int(config[slot_str]["joy1_brightness"])
-            joy2_brightness = int(config[slot_str]["joy2_brightness"])
-
             settle_time = int(config[slot_str]["settle_time"])
 
         except Exception as e:
@@ -171,24 +285,14 @@ class Daemon:
 
         sleep(settle_time)  # Let the game settle
 
-        self.__enable_joys(num_players, joy1_brightness, joy2_brightness)
-        self.__instrument.set_display_state(True)
+        profile = self.__slot_profile(config[slot_str])
+        if profile is None:
+            self.__game_sel = -1
+            return -1
+        joy1, joy2, joy1_brightness, joy2_brightness, effect = profile
+
+        # Joys and LEDs first, display last
+        self.__instrument.apply_scene(True, joy1, joy2, joy1_brightness, joy2_brightness, effect,
+                                      display_last=True)
 
         return slot
-
-    def __enable_joys(self, num_players: int, joy1_brightness: int = 0, joy2_brightness: int = 0) -> None:
-        """Set joys on/off and LED brightness"""
-        if num_players > 0:
-            self.__instrument.set_joy1_state(True)
-            self.__instrument.set_joy1_brightness(joy1_brightness)
-            if num_players > 1:
-                self.__instrument.set_joy2_state(True)
-                self.__instrument.set_joy2_brightness(joy2_brightness)
-            else:
-                self.__instrument.set_joy2_state(False)
-                self.__instrument.set_joy2_brightness(0)
-        else:
-            self.__instrument.set_joy1_state(False)
-            self.__instrument.set_joy1_brightness(0)
-            self.__instrument.set_joy2_state(False)
-            self.__instrument.set_joy2_brightness(0)
@@ -0,0 +1,139 @@
+"""Drain MCU scheduler trace (uno_trace build) and convert it to Chrome trace / Perfetto JSON"""
+import argparse
+import json
+import logging
+from time import sleep, monotonic
+from MCUInstrument import MCUInstrument
+
+logger = logging.getLogger(__name__)
+
+EVT_SWITCH = 1
+EVT_DELAY = 2
+EVT_GIVE = 3
+EVT_TAKE = 4
+EVT_TAKE_BLOCKED = 5
+EVT_TAKE_TIMEOUT = 6
+
+TICK_US = 16  # Unit of event deltas
+
+# First characters of FreeRTOS task names
+TASK_NAMES = {"a": "app", "d": "disp", "I": "IDLE"}
+
+# Names given to mutexes on MCU side
+OBJECT_NAMES = {"S": "state", "L": "log", "D": "disp"}
+
+OBJECT_EVENTS = {EVT_GIVE: "give", EVT_TAKE: "take",
+                 EVT_TAKE_BLOCKED: "block", EVT_TAKE_TIMEOUT: "timeout"}
+
+
+def drain(instrument: MCUInstrument, duration: float, poll_period: float) -> tuple:
+    """Collect trace bytes for given time, returns (bytes, dropped events)"""
+    data = bytearray()
+    dropped = 0
+    last_seq = None
+
+    end = monotonic() + duration
+    while monotonic() < end:
+        chunk = instrument.read_trace_chunk()
+        if chunk is None:
+            sleep(poll_period)
+            continue
+
+        seq, payload, dropped = chunk
+        if seq != last_seq:
+            data.extend(payload)
+            last_seq = seq
+            instrument.ack_trace_chunk(seq)
+
+        # Ring is emptier than chunk, let it fill a bit
+        if len(payload) == 0:
+            sleep(poll_period)
+
+    return bytes(data), dropped
+
+
+def decode(data: bytes) -> list:
+    """Decode raw trace into list of (timestamp us, type, arg)"""
+    events = []
+    stamp = 0
+    i = 0
+
+    while i + 2 < len(data):
+        evt_type, arg = data[i], chr(data[i + 1])
+        i += 2
+
+        delta = 0
+        shift = 0
+        while i < len(data):
+            b = data[i]
+            i += 1
+            delta |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+
+        stamp += delta * TICK_US
+        events.append((stamp, evt_type, arg))
+
+    return events
+
+
+def to_chrome(events: list) -> dict:
+    """Convert decoded events into Chrome trace format"""
+    trace = []
+    running = None
+    running_since = 0
+
+    def task_name(c: str) -> str:
+        return TASK_NAMES.get(c, c)
+
+    for stamp, evt_type, arg in events:
+        if evt_type == EVT_SWITCH:
+            if running is not None:
+                trace.append({"name": task_name(running), "ph": "X", "pid": 1, "tid": "cpu",
+                              "ts": running_since, "dur": stamp - running_since})
+            running = arg
+            running_since = stamp
+
+        elif evt_type == EVT_DELAY:
+            trace.append({"name": "delay", "ph": "i", "s": "t", "pid": 1,
+                          "tid": task_name(arg), "ts": stamp})
+
+        elif evt_type in OBJECT_EVENTS:
+            trace.append({"name": OBJECT_EVENTS[evt_type] + " " + OBJECT_NAMES.get(arg, arg),
+                          "ph": "i", "s": "t", "pid": 1,
+                          "tid": task_name(running) if running else "?", "ts": stamp})
+
+        else:
+            logger.warning("Unknown trace event %d", evt_type)
+
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main() -> None:
+    """Entry point"""
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--port", default="/dev/ttyAMA0")
+    parser.add_argument("--addr", type=int, default=1)
+    parser.add_argument("--timeout", type=float, default=0.5)
+    parser.add_argument("--duration", type=float, default=10,
+                        help="How long to record in seconds")
+    parser.add_argument("--poll", type=float, default=0.02,
+                        help="Delay between reads when trace ring is empty")
+    parser.add_argument("--out", default="mcu_trace.json")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO)
+
+    instrument = MCUInstrument(args.port, args.timeout, args.addr)
+    data, dropped = drain(instrument, args.duration, args.poll)
+
+    events = decode(data)
+    with open(args.out, "w", encoding="utf8") as f:
+        json.dump(to_chrome(events), f)
+
+    logger.info("Saved %d events to %s, %d dropped on MCU", len(events), args.out, dropped)
+
+
+if __name__ == "__main__":
+    main()